@@ -0,0 +1,74 @@
+#!/bin/sh
+# Measures the accumulation pass of threshold consensus with and without huge pages and NUMA thread pinning.
+# usage: benchmarks/memory_placement_benchmark.sh [num nodes] [num edges] [partitions] [num processors]
+# A random graph is generated with enough edges that the endpoint, count and weight arrays are well above the 2MB
+# from which they are placed, and an lpa ensemble of it is generated once into a shard directory. Every
+# configuration then runs reduce over it. Only the accumulation phase is reported: its wall clock and CPU seconds
+# come from the metrics file of the run, and perf stat is enabled only while that phase runs. The table has the
+# seconds, dTLB load misses, and node loads served locally and remotely. The counters are "-" when perf or the
+# events are not available.
+num_nodes=${1:-1000000}
+num_edges=${2:-8000000}
+num_partitions=${3:-5}
+num_processors=${4:-4}
+binary=./consensus_clustering
+work_directory=$(mktemp -d)
+trap 'rm -r "$work_directory"' EXIT
+
+edgelist="$work_directory/graph.tsv"
+partition_file="$work_directory/partition.file"
+awk -v num_nodes="$num_nodes" -v num_edges="$num_edges" 'BEGIN {
+    srand(1)
+    for(i = 0; i < num_edges; i ++) {
+        printf "%d\t%d\n", int(rand() * num_nodes), int(rand() * num_nodes)
+    }
+}' > "$edgelist"
+i=0
+while [ "$i" -lt "$num_partitions" ]; do
+    echo "lpa 1 -1" >> "$partition_file"
+    i=$((i + 1))
+done
+
+$binary generate --edgelist "$edgelist" --partition-file "$partition_file" --partitions "$num_partitions" --num-processors "$num_processors" --shard-dir "$work_directory/shards" --log-file "$work_directory/generate.log" > /dev/null || exit 1
+
+counter() {
+    value=$(grep ",$1" "$2" | cut -d, -f1)
+    case $value in
+        ''|*[!0-9]*) echo "-" ;;
+        *) echo "$value" ;;
+    esac
+}
+
+metric() {
+    grep '"phase":"accumulation"' "$2" | sed -n "s/.*\"$1\":\([0-9.]*\).*/\1/p" | head -n 1
+}
+
+# perf reads enable and disable commands from descriptor 8 and acknowledges them on 9
+mkfifo "$work_directory/perf.ctl" "$work_directory/perf.ack"
+exec 8<> "$work_directory/perf.ctl" 9<> "$work_directory/perf.ack"
+
+printf "huge_pages\tpin_threads\tseconds\tcpu_seconds\tdtlb_load_misses\tlocal_node_loads\tremote_node_loads\n"
+for huge_pages in no yes; do
+    for pin_threads in none numa; do
+        huge_pages_argument=""
+        if [ "$huge_pages" = yes ]; then
+            huge_pages_argument="--huge-pages"
+        fi
+        perf_command=""
+        if command -v perf > /dev/null 2>&1; then
+            perf_command="env CONSENSUS_PERF_PHASE=accumulation CONSENSUS_PERF_CTL_FD=8 CONSENSUS_PERF_ACK_FD=9 perf stat -D -1 --control fd:8,9 -x, -o $work_directory/perf.csv -e dTLB-load-misses,node-loads,node-load-misses"
+        fi
+        rm -f "$work_directory/perf.csv"
+        $perf_command $binary reduce --edgelist "$edgelist" --partition-file "$partition_file" --partitions "$num_partitions" --num-processors "$num_processors" --shard-dir "$work_directory/shards" $huge_pages_argument --pin-threads $pin_threads --output-file "$work_directory/reduce.out" --log-file "$work_directory/reduce.log" > /dev/null || exit 1
+        seconds=$(metric wall_seconds "$work_directory/reduce.log.metrics.jsonl")
+        cpu_seconds=$(metric cpu_seconds "$work_directory/reduce.log.metrics.jsonl")
+        dtlb_load_misses=$(counter dTLB-load-misses "$work_directory/perf.csv" 2> /dev/null || echo "-")
+        node_loads=$(counter node-loads "$work_directory/perf.csv" 2> /dev/null || echo "-")
+        remote_node_loads=$(counter node-load-misses "$work_directory/perf.csv" 2> /dev/null || echo "-")
+        local_node_loads="-"
+        if [ "$node_loads" != "-" ] && [ "$remote_node_loads" != "-" ]; then
+            local_node_loads=$((node_loads - remote_node_loads))
+        fi
+        printf "%s\t%s\t%s\t%s\t%s\t%s\t%s\n" $huge_pages $pin_threads "${seconds:--}" "${cpu_seconds:--}" "$dtlb_load_misses" "$local_node_loads" "$remote_node_loads"
+    done
+done
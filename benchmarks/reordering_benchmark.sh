@@ -0,0 +1,33 @@
+#!/bin/sh
+# Times every consensus mode end to end with each --reorder ordering.
+# usage: benchmarks/reordering_benchmark.sh [edgelist] [num processors] [repetitions]
+# Prints a tab separated table with the mean wall clock seconds per mode and ordering.
+edgelist=${1:-examples/ring_cliques_100_10.tsv}
+num_processors=${2:-1}
+repetitions=${3:-3}
+binary=./consensus_clustering
+work_directory=$(mktemp -d)
+trap 'rm -r "$work_directory"' EXIT
+
+printf "mode\tordering\tseconds\n"
+for mode in simple multi_resolution threshold ensemble_consensus; do
+    case $mode in
+        simple) partition_file=examples/sc_partition.file ;;
+        multi_resolution) partition_file=examples/mrc_partition.file ;;
+        *) partition_file=examples/tc_partition.file ;;
+    esac
+    # every row of the partition file is one partition of the ensemble
+    num_partitions=$(grep -c . "$partition_file")
+    for ordering in none degree rcm community; do
+        total=0
+        repetition=0
+        while [ "$repetition" -lt "$repetitions" ]; do
+            start=$(date +%s.%N)
+            $binary $mode --edgelist "$edgelist" --partition-file "$partition_file" --partitions "$num_partitions" --num-processors "$num_processors" --reorder $ordering --output-file "$work_directory/$mode.$ordering.out" --log-file "$work_directory/$mode.$ordering.log" > /dev/null || exit 1
+            end=$(date +%s.%N)
+            total=$(echo "$total + $end - $start" | bc -l)
+            repetition=$((repetition + 1))
+        done
+        printf "%s\t%s\t%.3f\n" $mode $ordering "$(echo "$total / $repetitions" | bc -l)"
+    done
+done
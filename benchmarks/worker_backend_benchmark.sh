@@ -0,0 +1,54 @@
+#!/bin/sh
+# Compares the thread and process worker backends on threshold consensus.
+# usage: benchmarks/worker_backend_benchmark.sh [edgelist] [partition file] [partitions] [num processors]
+# Prints a tab separated table with wall clock seconds, partitions per second and peak memory in KB.
+# Peak memory is the largest sum of the proportional set size (PSS) of the main process and its worker
+# processes, sampled every 50 ms from /proc/<pid>/smaps_rollup. PSS splits every page shared copy-on-write
+# among the processes mapping it, so the sum counts the graph once however many workers were forked.
+edgelist=${1:-examples/ring_cliques_100_10.tsv}
+partition_file=${2:-examples/tc_partition.file}
+# one partition per row of the partition file unless given
+num_partitions=${3:-$(grep -c . "$partition_file")}
+num_processors=${4:-4}
+binary=./consensus_clustering
+work_directory=$(mktemp -d)
+trap 'rm -r "$work_directory"' EXIT
+
+running() {
+    [ -e "/proc/$1" ] && ! grep -q "^State:[[:space:]]*Z" "/proc/$1/status" 2> /dev/null
+}
+
+process_tree() {
+    echo "$1"
+    for child in $(cat /proc/"$1"/task/*/children 2> /dev/null); do
+        process_tree "$child"
+    done
+}
+
+tree_pss_kb() {
+    total=0
+    for pid in $(process_tree "$1"); do
+        pss=$(awk '/^Pss:/ { print $2 }' "/proc/$pid/smaps_rollup" 2> /dev/null)
+        total=$((total + ${pss:-0}))
+    done
+    echo $total
+}
+
+printf "backend\tseconds\tpartitions_per_second\tpeak_pss_kb\n"
+for backend in threads processes; do
+    start=$(date +%s.%N)
+    $binary threshold --edgelist "$edgelist" --partition-file "$partition_file" --partitions "$num_partitions" --num-processors "$num_processors" --worker-backend $backend --output-file "$work_directory/$backend.out" --log-file "$work_directory/$backend.log" > /dev/null &
+    pid=$!
+    peak_pss=0
+    while running $pid; do
+        pss=$(tree_pss_kb $pid)
+        if [ "$pss" -gt "$peak_pss" ]; then
+            peak_pss=$pss
+        fi
+        sleep 0.05
+    done
+    wait $pid || exit 1
+    end=$(date +%s.%N)
+    seconds=$(echo "$end - $start" | bc -l)
+    printf "%s\t%.3f\t%.2f\t%s\n" $backend "$seconds" "$(echo "$num_partitions / $seconds" | bc -l)" "$peak_pss"
+done
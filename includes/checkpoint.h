@@ -0,0 +1,73 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <igraph/igraph.h>
+
+/*
+ * Iteration checkpoints of the iterative consensus methods. A checkpoint
+ * holds the graph an iteration started from and the thresholded graph it
+ * produced, both with their edges in id order and their weights, so a resumed
+ * run continues with exactly the same graphs. The partitions need no state of
+ * their own since every partition is seeded with its index. The layout is
+ *   char[4]  magic "CCCK"
+ *   uint32_t version
+ *   uint64_t configuration hash (input graph and partition file)
+ *   uint64_t iteration count
+ *   uint64_t payload size in bytes
+ *   uint64_t FNV-1a checksum of the payload
+ *   payload  for each graph: uint64_t nodes, uint64_t edges, int32_t endpoint
+ *            pairs, double weights
+ */
+struct GraphSnapshot {
+    int64_t num_nodes = 0;
+    std::vector<int> edges;
+    std::vector<double> weights;
+
+    static GraphSnapshot FromGraph(igraph_t* graph_ptr);
+    void ToGraph(igraph_t* graph_ptr) const;
+};
+
+struct IterationState {
+    uint64_t configuration_hash;
+    int iteration;
+    GraphSnapshot graph;
+    GraphSnapshot next_graph;
+};
+
+/*
+ * Writes checkpoints on a background thread so the next iteration starts right
+ * away. Only the newest submitted state is kept if the writer falls behind.
+ * Files are written to a temporary name, synced and renamed, and the two most
+ * recent checkpoints are kept so a run killed while writing one still has the
+ * previous one.
+ */
+class CheckpointWriter {
+    public:
+        static constexpr uint32_t version = 1;
+
+        CheckpointWriter(std::string checkpoint_directory);
+        ~CheckpointWriter();
+        void Submit(std::unique_ptr<IterationState> state);
+        static bool ReadLatest(std::string checkpoint_directory, uint64_t configuration_hash, IterationState& state);
+
+    private:
+        void WriterLoop();
+        bool Write(const IterationState& state);
+        std::string GetCheckpointFile(int iteration) const;
+
+        std::string checkpoint_directory;
+        std::mutex pending_mutex;
+        std::condition_variable pending_condition;
+        std::unique_ptr<IterationState> pending_state;
+        bool stopping = false;
+        std::thread writer_thread;
+};
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef CLUSTERING_FILE_READER_H
+#define CLUSTERING_FILE_READER_H
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <omp.h>
+
+#include "membership_io.h"
+
+// lets the node name map be probed with views into a mapped file without building a std::string per line
+struct NodeNameHash {
+    using is_transparent = void;
+    size_t operator()(std::string_view node_name) const {
+        return std::hash<std::string_view>{}(node_name);
+    }
+};
+typedef std::unordered_map<std::string, int, NodeNameHash, std::equal_to<>> NodeNameToIdMap;
+
+/*
+ * Reads "node cluster" clustering files straight onto graph vertex ids. Every
+ * file is memory mapped and cut into line aligned chunks, and the chunks of all
+ * files are parsed concurrently. The result holds one label per vertex with -1
+ * for nodes that are missing from the file or sit in a singleton cluster, where
+ * cluster sizes include nodes that are not in the graph. A node listed more
+ * than once in the same file ends up with one of its labels.
+ * Binary membership files are accepted as well when their id map matches the
+ * graph or is the identity, in which case label i belongs to the node named i.
+ * Read throws a std::runtime_error for a binary file that is corrupt or
+ * belongs to another graph.
+ */
+class ClusteringFileReader {
+    public:
+        ClusteringFileReader(const NodeNameToIdMap* node_name_to_id_map, uint64_t id_map, int num_threads) : node_name_to_id_map(node_name_to_id_map), id_map(id_map), num_threads(num_threads) {
+        };
+        std::vector<std::vector<int>> Read(const std::vector<std::string>& clustering_files);
+        std::vector<int> Read(const std::string& clustering_file) {
+            return std::move(this->Read(std::vector<std::string>{clustering_file})[0]);
+        }
+
+    private:
+        struct Chunk {
+            int file_index;
+            const char* begin;
+            const char* end;
+            // (vertex id or -1, chunk local cluster label) per line
+            std::vector<std::pair<int, int>> entries;
+            std::unordered_map<std::string_view, int> cluster_name_to_label_map;
+            std::vector<std::string_view> cluster_names;
+            std::vector<int> local_to_file_label;
+        };
+        void ParseChunk(Chunk& chunk);
+        bool ReadBinaryFile(const std::string& clustering_file, std::vector<int>& labels, std::vector<std::atomic<int>>& cluster_sizes);
+
+        const NodeNameToIdMap* node_name_to_id_map;
+        uint64_t id_map;
+        int num_threads;
+};
+
+#endif
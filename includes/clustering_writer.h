@@ -0,0 +1,27 @@
+#ifndef CLUSTERING_WRITER_H
+#define CLUSTERING_WRITER_H
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <omp.h>
+
+#include "membership_io.h"
+
+/*
+ * Writes "node cluster" text clusterings from a dense label array. Blocks of
+ * nodes are formatted with std::to_chars into per thread buffers in parallel
+ * and the buffers are written to the file in node order with one write call
+ * each. Nodes labelled MembershipIO::no_membership are skipped.
+ */
+class ClusteringWriter {
+    public:
+        // node_names is indexed by node id, without it the node id itself is written
+        static bool WriteText(std::string output_file, const std::vector<uint32_t>& labels, const std::vector<const char*>* node_names = nullptr);
+        // renumbers the clusters 0, 1, ... from the largest down, ties keep their original order
+        static void RelabelBySize(std::vector<uint32_t>& labels);
+
+    private:
+        static constexpr size_t block_size = 1 << 16;
+};
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef CONNECTIVITY_MODIFIER_H
+#define CONNECTIVITY_MODIFIER_H
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <vector>
+#include <omp.h>
+
+#include <igraph/igraph.h>
+
+/*
+ * In-process connectivity modifier (CM). Every cluster whose minimum edge cut
+ * is at most log10 of its size is cut in two, each side is reclustered with the
+ * same algorithm and the resulting clusters are checked again. Clusters are
+ * processed as OpenMP tasks and every induced subgraph is built from the
+ * adjacency of the shared graph, which is only read, together with its edge
+ * weights and supernode sizes. The cuts run concurrently, the reclustering of
+ * the sides one at a time because it uses igraph's global rng.
+ */
+class ConnectivityModifier {
+    public:
+        ConnectivityModifier(igraph_t* graph_ptr, std::function<std::map<int, int>(igraph_t*)> recluster) : graph_ptr(graph_ptr), recluster(recluster) {
+        };
+        std::map<int, int> Run(const std::map<int, int>& partition_map);
+
+    private:
+        void ProcessCluster(const std::vector<int>& members);
+        void ReclusterSide(const std::vector<int>& side);
+        void BuildSubgraph(const std::vector<int>& members, igraph_t* subgraph_ptr);
+
+        static inline bool IsWellConnected(double mincut_value, int64_t num_nodes) {
+            return mincut_value > std::log10(num_nodes);
+        }
+
+        igraph_t* graph_ptr;
+        std::function<std::map<int, int>(igraph_t*)> recluster;
+        std::mutex final_clusters_mutex;
+        std::vector<std::vector<int>> final_clusters;
+};
+
+#endif
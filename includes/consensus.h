@@ -1,14 +1,21 @@
 #ifndef CONSENSUS_H
 #define CONSENSUS_H
+#include <cctype>
 #include <cstdio>
+#include <cmath>
+#include <charconv>
 #include <string>
 #include <iostream>
 #include <fstream>
 #include <vector>
 #include <map>
+#include <memory>
+#include <memory_resource>
 #include <set>
+#include <unordered_map>
 #include <chrono>
 #include <condition_variable>
+#include <functional>
 #include <thread>
 #include <omp.h>
 
@@ -18,6 +25,25 @@
 #include <libleidenalg/CPMVertexPartition.h>
 #include <libleidenalg/ModularityVertexPartition.h>
 
+#include "csr_graph.h"
+#include "parallel_leiden.h"
+#include "label_propagation.h"
+#include "connectivity_modifier.h"
+#include "partition_cache.h"
+#include "checkpoint.h"
+#include "membership_ring_buffer.h"
+#include "shared_graph_segment.h"
+#include "mapped_array.h"
+#include "memory_planner.h"
+#include "scratch_arena.h"
+#include "phase_metrics.h"
+#include "union_find.h"
+#include "graph_coarsening.h"
+#include "graph_pruning.h"
+#include "graph_reordering.h"
+#include "clustering_file_reader.h"
+#include "clustering_writer.h"
+
 
 class Consensus {
     public:
@@ -26,13 +52,17 @@ class Consensus {
             if(this->log_level > 0) {
                 this->start_time = std::chrono::steady_clock::now();
                 this->log_file_handle.open(this->log_file);
+                PhaseMetrics::Open(this->log_file + ".metrics.jsonl");
             }
         };
         Consensus(std::string edgelist, std::string partition_file, std::string final_algorithm, double threshold, double final_resolution, int num_partitions, int num_processors, std::string output_file, std::string log_file, int log_level) : edgelist(edgelist), partition_file(partition_file), final_algorithm(final_algorithm), threshold(threshold), final_resolution(final_resolution), num_partitions(num_partitions), num_processors(num_processors), output_file(output_file), log_file(log_file), log_level(log_level), num_calls_to_log_write(0) {
             if(this->log_level > 0) {
                 this->start_time = std::chrono::steady_clock::now();
                 this->log_file_handle.open(this->log_file);
+                PhaseMetrics::Open(this->log_file + ".metrics.jsonl");
             }
+            // the final clustering run happens on this thread once the workers are done
+            omp_set_num_threads(this->num_processors);
 
             std::ifstream partition_file_handle(this->partition_file);
             std::string current_algorithm;
@@ -54,7 +84,10 @@ class Consensus {
             if(this->log_level > 0) {
                 this->start_time = std::chrono::steady_clock::now();
                 this->log_file_handle.open(this->log_file);
+                PhaseMetrics::Open(this->log_file + ".metrics.jsonl");
             }
+            // the final clustering run happens on this thread once the workers are done
+            omp_set_num_threads(this->num_processors);
 
             std::ifstream partition_file_handle(this->partition_file);
             std::string current_algorithm;
@@ -74,80 +107,168 @@ class Consensus {
         };
         virtual int main() = 0;
         int WriteToLogFile(std::string message, int message_type);
-        void WritePartitionMap(std::map<int, int>& final_partition);
-        void WritePartitionMapWithTranslation(std::map<int, int>& final_partition, igraph_t* graph_ptr);
+        // the writers log a failed write as an error and return false so the subcommand can exit non-zero
+        bool WritePartitionMap(std::map<int, int>& final_partition);
+        bool WritePartitionMap(std::map<int, int>& final_partition, std::string output_file);
+        bool WritePartitionMapWithTranslation(std::map<int, int>& final_partition, igraph_t* graph_ptr);
+        bool WriteMembership(std::vector<uint32_t>& labels, std::string output_file, igraph_t* translation_graph_ptr = nullptr);
         void LoadIgraphFromFile(igraph_t* graph_ptr);
-        void StartWorkers(igraph_t* graph);
+        void ReadEdgelist(igraph_t* graph_ptr, bool simplify);
+        bool AttachSharedGraph(bool simplify);
+        void PreprocessGraph(igraph_t* graph_ptr);
+        bool ResumeFromCheckpoint(igraph_t* graph_ptr, igraph_t* next_graph_ptr, int& iter_count);
+        // settings a mode adds to the checkpoint configuration hash beyond the partition file and threshold
+        virtual std::vector<double> GetConvergenceSettings() const {
+            return {};
+        }
+        void CheckpointIteration(igraph_t* graph_ptr, igraph_t* next_graph_ptr, int iter_count);
+        void StartWorkers(igraph_t* graph, int first_partition = 0, int last_partition = -1);
+        void StartProcessWorkers(igraph_t* graph_ptr, int first_partition, int last_partition, PartitionCache* partition_cache);
+        void PlanMemory(igraph_t* graph_ptr, bool iterative, bool streaming_possible);
+        void LogMeasuredPeak();
+        int GetNumWorkers() const {
+            return this->memory_plan.num_workers > 0 ? this->memory_plan.num_workers : this->num_processors;
+        }
+        void SetCacheDirectory(std::string cache_directory) {
+            this->cache_directory = cache_directory;
+        }
+        void SetOutputFormat(std::string output_format) {
+            this->output_format = output_format;
+        }
+        void SetRelabelBySize(bool relabel_by_size) {
+            this->relabel_by_size = relabel_by_size;
+        }
+        void SetCoarsening(bool coarsening_flag) {
+            this->coarsening_flag = coarsening_flag;
+        }
+        void SetPruneMode(std::string prune_mode) {
+            this->prune_mode = prune_mode;
+        }
+        void SetReorderMode(std::string reorder_mode) {
+            this->reorder_mode = reorder_mode;
+        }
+        void SetWorkerBackend(std::string worker_backend) {
+            this->worker_backend = worker_backend;
+        }
+        void SetSharedGraph(std::string shared_graph_name) {
+            this->shared_graph_name = shared_graph_name;
+        }
+        void SetCheckpointDirectory(std::string checkpoint_directory) {
+            this->checkpoint_directory = checkpoint_directory;
+        }
+        void SetResume(bool resume_flag) {
+            this->resume_flag = resume_flag;
+        }
+        void SetOutOfCoreDirectory(std::string out_of_core_directory) {
+            this->out_of_core_directory = out_of_core_directory;
+        }
+        void SetMaxMemory(int64_t max_memory) {
+            this->max_memory = max_memory;
+        }
+        void SetMemoryPlacement(bool huge_pages_flag, std::string pin_threads) {
+            MemoryPlacement::huge_pages_flag = huge_pages_flag;
+            if(pin_threads == "numa") {
+                int num_numa_nodes = MemoryPlacement::PinThreads(this->num_processors);
+                this->WriteToLogFile("Pinned " + std::to_string(this->num_processors) + " threads to " + std::to_string(num_numa_nodes) + " NUMA nodes", 1);
+            }
+        }
+
+        static inline int64_t ParseMemorySize(const std::string& memory_size) {
+            // plain bytes or a K, M, G or T suffix in powers of 1024, 0 means no limit
+            size_t suffix_position = 0;
+            int64_t value = std::stoll(memory_size, &suffix_position);
+            std::string suffix = memory_size.substr(suffix_position);
+            const std::string suffixes = "KMGT";
+            int64_t multiplier = 1;
+            if(!suffix.empty()) {
+                size_t suffix_index = suffixes.find(std::toupper(static_cast<unsigned char>(suffix[0])));
+                if(suffix_index == std::string::npos || (suffix.size() > 1 && suffix.substr(1) != "B" && suffix.substr(1) != "b")) {
+                    throw std::invalid_argument("--max-memory has to be a number of bytes optionally followed by K, M, G, or T");
+                }
+                multiplier = int64_t(1) << (10 * (suffix_index + 1));
+            }
+            if(value < 0) {
+                throw std::invalid_argument("--max-memory can not be negative");
+            }
+            return value * multiplier;
+        }
         virtual ~Consensus() {
             if(this->log_level > 0) {
                 this->log_file_handle.close();
+                PhaseMetrics::Close();
             }
         }
 
         static inline std::map<int, int> GetConnectedComponents(igraph_t* graph_ptr) {
-            std::map<int, int> partition;
-            igraph_vector_int_t component_id_vector;
-            igraph_vector_int_init(&component_id_vector, 0);
-            igraph_vector_int_t membership_size_vector;
-            igraph_vector_int_init(&membership_size_vector, 0);
-            igraph_integer_t number_of_components;
-            igraph_connected_components(graph_ptr, &component_id_vector, &membership_size_vector, &number_of_components, IGRAPH_WEAK);
+            return MembershipIO::LabelsToPartitionMap(Consensus::GetThresholdComponents(graph_ptr, nullptr, 0));
+        }
 
-            igraph_eit_t eit;
-            igraph_eit_create(graph_ptr, igraph_ess_all(IGRAPH_EDGEORDER_ID), &eit);
-            for(; !IGRAPH_EIT_END(eit); IGRAPH_EIT_NEXT(eit)) {
-                igraph_integer_t current_edge = IGRAPH_EIT_GET(eit);
-                int from_node = IGRAPH_FROM(graph_ptr, current_edge);
-                if(!partition.contains(from_node)) {
-                    int from_component_id = VECTOR(component_id_vector)[from_node];
-                    if(VECTOR(membership_size_vector)[from_component_id] > 1) {
-                        partition[from_node] = from_component_id;
-                    }
-                }
-                int to_node = IGRAPH_TO(graph_ptr, current_edge);
-                if(!partition.contains(to_node)) {
-                    int from_component_id = VECTOR(component_id_vector)[to_node];
-                    if(VECTOR(membership_size_vector)[from_component_id] > 1) {
-                        partition[to_node] = from_component_id;
-                    }
+        // connected components of the edges whose weight is at least the threshold (all edges without weights)
+        // without rebuilding the graph, nodes outside of a component with an edge get no_membership
+        static inline std::vector<uint32_t> GetThresholdComponents(igraph_t* graph_ptr, const igraph_vector_t* edge_weights, double threshold) {
+            int num_nodes = igraph_vcount(graph_ptr);
+            igraph_integer_t num_edges = igraph_ecount(graph_ptr);
+            ConcurrentUnionFind union_find(num_nodes);
+            #pragma omp parallel for schedule(dynamic, 4096)
+            for(igraph_integer_t current_edge = 0; current_edge < num_edges; current_edge ++) {
+                if(edge_weights == nullptr || VECTOR(*edge_weights)[current_edge] >= threshold) {
+                    union_find.Union(IGRAPH_FROM(graph_ptr, current_edge), IGRAPH_TO(graph_ptr, current_edge));
                 }
+            }
 
+            std::vector<int> component_ids;
+            std::vector<int> component_sizes;
+            union_find.GetComponents(component_ids, component_sizes);
+            std::vector<uint32_t> labels(num_nodes);
+            #pragma omp parallel for schedule(static)
+            for(int node_id = 0; node_id < num_nodes; node_id ++) {
+                int component_id = component_ids[node_id];
+                labels[node_id] = component_sizes[component_id] > 1 ? component_id : MembershipIO::no_membership;
             }
-            igraph_eit_destroy(&eit);
-            igraph_vector_int_destroy(&component_id_vector);
-            igraph_vector_int_destroy(&membership_size_vector);
-            return partition;
+            return labels;
         }
 
-
         static inline void RemoveEdgesBasedOnThreshold(igraph_t* graph, double current_threshold) {
-            igraph_vector_int_t edges_to_remove;
-            igraph_vector_int_init(&edges_to_remove, 0);
+            // the edge ids live in the scratch arena and igraph reads them through a view instead of a copy
+            ScratchArena::Scope scratch_scope;
+            std::pmr::vector<igraph_integer_t> edges_to_remove(scratch_scope.Resource());
             igraph_eit_t eit;
             igraph_eit_create(graph, igraph_ess_all(IGRAPH_EDGEORDER_ID), &eit);
             for(; !IGRAPH_EIT_END(eit); IGRAPH_EIT_NEXT(eit)) {
                 igraph_real_t current_edge_weight = EAN(graph, "weight", IGRAPH_EIT_GET(eit));
                 if(current_edge_weight < current_threshold) {
-                    igraph_vector_int_push_back(&edges_to_remove, IGRAPH_EIT_GET(eit));
+                    edges_to_remove.push_back(IGRAPH_EIT_GET(eit));
                 }
             }
+            igraph_eit_destroy(&eit);
+            if(edges_to_remove.empty()) {
+                return;
+            }
+            igraph_vector_int_t edges_to_remove_view;
+            igraph_vector_int_view(&edges_to_remove_view, edges_to_remove.data(), edges_to_remove.size());
             igraph_es_t es;
-            igraph_es_vector_copy(&es, &edges_to_remove);
+            igraph_es_vector(&es, &edges_to_remove_view);
             igraph_delete_edges(graph, es);
-            igraph_eit_destroy(&eit);
             igraph_es_destroy(&es);
-            igraph_vector_int_destroy(&edges_to_remove);
         }
 
         static inline void RunLouvainAndUpdatePartition(std::map<int, int>& partition_map, int seed, double resolution_value, igraph_t* graph) {
             igraph_vector_int_t membership;
             igraph_vector_int_init(&membership, 0);
             igraph_rng_seed(igraph_rng_default(), seed);
-            igraph_community_multilevel(graph, 0, resolution_value, &membership, 0, 0);
+            igraph_vector_t coarse_weight_vector;
+            igraph_vector_init(&coarse_weight_vector, 0);
+            bool coarse_flag = GraphCoarsening::IsCoarseGraph(graph);
+            if(coarse_flag) {
+                igraph_cattribute_EANV(graph, "coarse_weight", igraph_ess_all(IGRAPH_EDGEORDER_ID), &coarse_weight_vector);
+            }
+            igraph_community_multilevel(graph, coarse_flag ? &coarse_weight_vector : 0, resolution_value, &membership, 0, 0);
+            igraph_vector_destroy(&coarse_weight_vector);
 
             igraph_eit_t eit;
             igraph_eit_create(graph, igraph_ess_all(IGRAPH_EDGEORDER_ID), &eit);
-            std::set<int> visited;
+            ScratchArena::Scope scratch_scope;
+            std::pmr::set<int> visited(scratch_scope.Resource());
             for (; !IGRAPH_EIT_END(eit); IGRAPH_EIT_NEXT(eit)) {
                 igraph_integer_t current_edge = IGRAPH_EIT_GET(eit);
                 int from_node = IGRAPH_FROM(graph, current_edge);
@@ -165,6 +286,22 @@ class Consensus {
             igraph_vector_int_destroy(&membership);
         }
 
+        static inline std::unique_ptr<Graph> GetLeidenGraph(igraph_t* graph) {
+            if(!GraphCoarsening::IsCoarseGraph(graph)) {
+                return std::make_unique<Graph>(graph);
+            }
+            // supernodes carry their number of original nodes and edges their multiplicity
+            std::vector<double> edge_weights(igraph_ecount(graph));
+            for(igraph_integer_t current_edge = 0; current_edge < igraph_ecount(graph); current_edge ++) {
+                edge_weights[current_edge] = EAN(graph, "coarse_weight", current_edge);
+            }
+            std::vector<size_t> node_sizes(igraph_vcount(graph));
+            for(igraph_integer_t node_id = 0; node_id < igraph_vcount(graph); node_id ++) {
+                node_sizes[node_id] = VAN(graph, "coarse_size", node_id);
+            }
+            return std::make_unique<Graph>(graph, edge_weights, node_sizes, true);
+        }
+
         static inline void RunLeidenAndUpdatePartition(std::map<int, int>& partition_map, MutableVertexPartition* partition, int seed, igraph_t* graph, int num_iter= 2) {
             Optimiser o;
             o.set_rng_seed(seed);
@@ -173,7 +310,8 @@ class Consensus {
             }
             igraph_eit_t eit;
             igraph_eit_create(graph, igraph_ess_all(IGRAPH_EDGEORDER_ID), &eit);
-            std::set<int> visited;
+            ScratchArena::Scope scratch_scope;
+            std::pmr::set<int> visited(scratch_scope.Resource());
             for (; !IGRAPH_EIT_END(eit); IGRAPH_EIT_NEXT(eit)) {
                 igraph_integer_t current_edge = IGRAPH_EIT_GET(eit);
                 int from_node = IGRAPH_FROM(graph, current_edge);
@@ -190,18 +328,58 @@ class Consensus {
             igraph_eit_destroy(&eit);
         }
 
+        static inline void RunParallelLeidenAndUpdatePartition(std::map<int, int>& partition_map, ParallelLeiden::Quality quality, double resolution_value, int seed, igraph_t* graph, int num_iter = 2) {
+            bool coarse_flag = GraphCoarsening::IsCoarseGraph(graph);
+            CSRGraph csr_graph(graph, coarse_flag ? "coarse_weight" : nullptr, coarse_flag ? "coarse_size" : nullptr);
+            ParallelLeiden leiden(&csr_graph, quality, resolution_value, seed);
+            std::vector<int> membership = leiden.Run(num_iter);
+            for(int node_id = 0; node_id < csr_graph.num_nodes; node_id ++) {
+                // same node set as the edge walks above, only nodes with an incident edge
+                if(csr_graph.Degree(node_id) > 0) {
+                    partition_map[node_id] = membership[node_id];
+                }
+            }
+        }
+
+        static inline void RunLabelPropagationAndUpdatePartition(std::map<int, int>& partition_map, int seed, igraph_t* graph) {
+            CSRGraph csr_graph(graph, GraphCoarsening::IsCoarseGraph(graph) ? "coarse_weight" : nullptr);
+            LabelPropagation label_propagation(&csr_graph, seed);
+            std::vector<int> membership = label_propagation.Run();
+            for(int node_id = 0; node_id < csr_graph.num_nodes; node_id ++) {
+                if(csr_graph.Degree(node_id) > 0) {
+                    partition_map[node_id] = membership[node_id];
+                }
+            }
+        }
+
         static inline void SetIgraphAllEdgesWeight(igraph_t* graph, double weight) {
             igraph_eit_t eit;
             igraph_eit_create(graph, igraph_ess_all(IGRAPH_EDGEORDER_ID), &eit);
             std::set<std::pair<int, int>> edge_set;
             for(; !IGRAPH_EIT_END(eit); IGRAPH_EIT_NEXT(eit)) {
-                int current_edge = IGRAPH_EIT_GET(eit);
                 SETEAN(graph, "weight", IGRAPH_EIT_GET(eit), weight);
             }
             igraph_eit_destroy(&eit);
         }
 
-        static inline void ClusterWorker(std::string edgelist, std::vector<std::string>& algorithm_vector, std::vector<double>& clustering_parameter_vector, igraph_t* graph_ptr) {
+        static inline std::map<int, int> ComputePartition(std::string edgelist, std::vector<std::string>& algorithm_vector, std::vector<double>& clustering_parameter_vector, int partition_index, igraph_t* graph_ptr, PartitionCache* partition_cache) {
+            bool worker_flag = true;
+            PhaseMetrics::Phase clustering_phase("clustering", partition_index, worker_flag);
+            clustering_phase.edges_processed = igraph_ecount(graph_ptr);
+            std::map<int, int> clustering;
+            if(partition_cache == nullptr || !partition_cache->Lookup(algorithm_vector[partition_index], clustering_parameter_vector[partition_index], partition_index, clustering)) {
+                clustering = Consensus::GetCommunities(edgelist, algorithm_vector[partition_index], partition_index, clustering_parameter_vector[partition_index], graph_ptr);
+                if(partition_cache != nullptr) {
+                    partition_cache->Store(algorithm_vector[partition_index], clustering_parameter_vector[partition_index], partition_index, clustering);
+                }
+            }
+            return clustering;
+        }
+
+        static inline void ClusterWorker(std::string edgelist, std::vector<std::string>& algorithm_vector, std::vector<double>& clustering_parameter_vector, igraph_t* graph_ptr, int num_threads_per_worker, PartitionCache* partition_cache) {
+            // OpenMP based algorithms share the processors with the other workers
+            omp_set_num_threads(num_threads_per_worker);
+            MemoryPlacement::UnpinThisThread();
             while(true) {
                 std::unique_lock<std::mutex> num_partition_lock{Consensus::num_partition_index_mutex};
                 int current_index = Consensus::num_partition_index_queue.front();
@@ -211,13 +389,21 @@ class Consensus {
                     // done with work
                     return;
                 }
-                std::map<int, int> clustering = Consensus::GetCommunities(edgelist, algorithm_vector[current_index], current_index, clustering_parameter_vector[current_index], graph_ptr);
+                // the scratch structures of a partition are dropped together before the next one starts
+                ScratchArena::Scope partition_scope;
+                std::map<int, int> clustering = Consensus::ComputePartition(edgelist, algorithm_vector, clustering_parameter_vector, current_index, graph_ptr, partition_cache);
+                if(Consensus::partition_sink) {
+                    // streaming runs take the membership as soon as it is done and only the index is queued
+                    Consensus::partition_sink(current_index, MembershipIO::PartitionMapToLabels(clustering, igraph_vcount(graph_ptr)));
+                    clustering.clear();
+                }
                 std::map<int, std::vector<int>> cluster_to_nodes_map;
-                if(Consensus::voting_flag) cluster_to_nodes_map = Consensus::GetClusterToNodeMap(clustering);
+                if(Consensus::voting_flag && Consensus::voting_maps_flag) cluster_to_nodes_map = Consensus::GetClusterToNodeMap(clustering);
                 {
                     std::lock_guard<std::mutex> done_being_clustered_guard(Consensus::done_being_clustered_mutex);
                     Consensus::done_being_clustered_clusterings.push(clustering);
-                    if(Consensus::voting_flag) Consensus::done_being_clustered_cluster_to_nodes_map.push(cluster_to_nodes_map);
+                    Consensus::done_being_clustered_indices.push(current_index);
+                    if(Consensus::voting_flag && Consensus::voting_maps_flag) Consensus::done_being_clustered_cluster_to_nodes_map.push(cluster_to_nodes_map);
                 }
             }
         }
@@ -232,9 +418,9 @@ class Consensus {
         }
 
         static inline std::map<int, int> GetCommunities(std::string edgelist, std::string algorithm, int seed, double clustering_parameter, igraph_t* graph_ptr) {
-            // TO DO -- add system call to run CM if it is appended to the algorithm i.e. "leiden-cpm-cm"
-            //bool cm_flag = algorithm.compare(algorithm.size()-3, 3, "-cm");
-            //if(cm_flag) algorithm.erase(algorithm.size()-3, algorithm.size());
+            // CM runs in-process if it is appended to the algorithm i.e. "leiden-cpm-cm"
+            bool cm_flag = algorithm.size() > 3 && algorithm.compare(algorithm.size() - 3, 3, "-cm") == 0;
+            if(cm_flag) algorithm.erase(algorithm.size() - 3);
 
             std::map<int, int> partition_map;
             igraph_t graph;
@@ -252,20 +438,30 @@ class Consensus {
             if(algorithm == "louvain") {
                 RunLouvainAndUpdatePartition(partition_map, seed, clustering_parameter, &graph);
             } else if(algorithm == "leiden-cpm") {
-                Graph leiden_graph(&graph);
-                CPMVertexPartition partition(&leiden_graph, clustering_parameter);
+                std::unique_ptr<Graph> leiden_graph = Consensus::GetLeidenGraph(&graph);
+                CPMVertexPartition partition(leiden_graph.get(), clustering_parameter);
                 RunLeidenAndUpdatePartition(partition_map, &partition, seed, &graph);
             } else if(algorithm == "leiden-mod") {
-                Graph leiden_graph(&graph);
-                ModularityVertexPartition partition(&leiden_graph);
+                std::unique_ptr<Graph> leiden_graph = Consensus::GetLeidenGraph(&graph);
+                ModularityVertexPartition partition(leiden_graph.get());
                 RunLeidenAndUpdatePartition(partition_map, &partition, seed, &graph);
+            } else if(algorithm == "parallel-leiden-cpm") {
+                RunParallelLeidenAndUpdatePartition(partition_map, ParallelLeiden::Quality::CPM, clustering_parameter, seed, &graph);
+            } else if(algorithm == "parallel-leiden-mod") {
+                RunParallelLeidenAndUpdatePartition(partition_map, ParallelLeiden::Quality::Modularity, 1, seed, &graph);
+            } else if(algorithm == "lpa") {
+                RunLabelPropagationAndUpdatePartition(partition_map, seed, &graph);
             } else {
                 throw std::invalid_argument("GetCommunities(): Unsupported algorithm");
             }
 
-            //if(cm_flag) {
-            //    //system call to CM
-            //}
+            if(cm_flag) {
+                // the sides of every cut are reclustered with the same algorithm on their induced subgraph
+                ConnectivityModifier cm(&graph, [&](igraph_t* subgraph_ptr) {
+                    return Consensus::GetCommunities("", algorithm, seed, clustering_parameter, subgraph_ptr);
+                });
+                partition_map = cm.Run(partition_map);
+            }
 
             if(graph_ptr == nullptr) {
                 igraph_destroy(&graph);
@@ -285,26 +481,27 @@ class Consensus {
             igraph_es_destroy(&graph_es);
         }
 
-        static inline std::map<std::string, std::string> ReadClusteringFile(std::string clustering_file) {
-            std::map<std::string, std::string> input_clustering;
-            std::map<std::string, std::vector<std::string>> cluster_id_to_membership_map;
-            std::string node_id;
-            std::string cluster_id;
-            std::ifstream clustering_file_handle(clustering_file);
-            while(clustering_file_handle >> node_id >> cluster_id) {
-                /* input_clustering[node_id] = cluster_id; */
-                cluster_id_to_membership_map[cluster_id].push_back(node_id);
+        static inline NodeNameToIdMap GetNodeNameToIdMap(igraph_t* graph_ptr) {
+            NodeNameToIdMap node_name_to_id_map;
+            node_name_to_id_map.reserve(igraph_vcount(graph_ptr));
+            for(int node_id = 0; node_id < igraph_vcount(graph_ptr); node_id ++) {
+                node_name_to_id_map[VAS(graph_ptr, "name", node_id)] = node_id;
             }
+            return node_name_to_id_map;
+        }
 
-            for(auto const& [cluster_id, membership_vector] : cluster_id_to_membership_map) {
-                if(membership_vector.size() > 1) {
-                    for(int i = 0; i < membership_vector.size(); i ++) {
-                        input_clustering[membership_vector[i]] = cluster_id;
-                    }
+        // id map reference of binary membership files written against a graph with named vertices
+        static inline uint64_t GetNodeNameIdMap(igraph_t* graph_ptr) {
+            const uint64_t fnv_offset = 0xcbf29ce484222325ULL;
+            const uint64_t fnv_prime = 0x100000001b3ULL;
+            uint64_t id_map = fnv_offset;
+            for(int node_id = 0; node_id < igraph_vcount(graph_ptr); node_id ++) {
+                for(const char* c = VAS(graph_ptr, "name", node_id); *c != '\0'; c ++) {
+                    id_map = (id_map ^ static_cast<uint8_t>(*c)) * fnv_prime;
                 }
+                id_map = (id_map ^ '\n') * fnv_prime;
             }
-
-            return input_clustering;
+            return id_map == MembershipIO::identity_id_map ? 1 : id_map;
         }
 
     protected:
@@ -324,11 +521,32 @@ class Consensus {
         std::vector<double> weight_vector;
         std::vector<double> clustering_parameter_vector;
         int num_calls_to_log_write;
+        std::string cache_directory;
+        std::string output_format = "text";
+        bool relabel_by_size = false;
+        bool coarsening_flag = false;
+        std::string prune_mode = "none";
+        std::unique_ptr<GraphPruning> pruning;
+        std::string reorder_mode = "none";
+        std::unique_ptr<GraphReordering> reordering;
+        std::string worker_backend = "threads";
+        std::string shared_graph_name;
+        std::unique_ptr<SharedGraphSegment> shared_graph;
+        std::string checkpoint_directory;
+        bool resume_flag = false;
+        uint64_t configuration_hash = 0;
+        std::unique_ptr<CheckpointWriter> checkpoint_writer;
+        std::string out_of_core_directory;
+        int64_t max_memory = 0;
+        MemoryPlan memory_plan;
+        static inline bool voting_maps_flag = true;
+        static inline std::function<void(int, const std::vector<uint32_t>&)> partition_sink;
         static inline bool voting_flag = false;
         static inline std::mutex num_partition_index_mutex;
         static inline std::queue<int> num_partition_index_queue;
         static inline std::mutex done_being_clustered_mutex;
         static inline std::queue<std::map<int, int>> done_being_clustered_clusterings;
+        static inline std::queue<int> done_being_clustered_indices;
         static inline std::queue<std::map<int, std::vector<int>>> done_being_clustered_cluster_to_nodes_map;
 };
 
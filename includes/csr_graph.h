@@ -0,0 +1,48 @@
+#ifndef CSR_GRAPH_H
+#define CSR_GRAPH_H
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <omp.h>
+
+#include <igraph/igraph.h>
+
+#include "memory_placement.h"
+
+/*
+ * Compressed sparse row view of an undirected igraph graph used by the
+ * OpenMP clustering kernels. Every undirected edge is stored in both
+ * endpoint rows, self loops are stored once. Node strengths are kept
+ * explicitly so coarse graphs built during aggregation keep their degrees.
+ * The edge arrays are first-touched by the OpenMP team (see MemoryPlacement).
+ */
+class CSRGraph {
+    public:
+        CSRGraph() : num_nodes(0), total_strength(0) {};
+        CSRGraph(igraph_t* graph_ptr, const char* weight_attribute = nullptr, const char* node_size_attribute = nullptr);
+
+        inline int64_t Degree(int node_id) const {
+            return this->offsets[node_id + 1] - this->offsets[node_id];
+        }
+
+        int num_nodes;
+        double total_strength; // 2m for the modularity null model
+        PlacedVector<int64_t> offsets;
+        PlacedVector<int> neighbors;
+        PlacedVector<double> weights;
+        std::vector<double> node_sizes;
+        std::vector<double> node_strengths;
+};
+
+/*
+ * splitmix64 finaliser, used to derive per vertex random decisions from a
+ * seed so that the kernels give the same answer for any number of threads
+ */
+static inline uint64_t HashVertex(uint64_t seed, uint64_t round, uint64_t node_id) {
+    uint64_t z = seed * 0x9E3779B97F4A7C15ULL + round * 0xBF58476D1CE4E5B9ULL + node_id + 0x94D049BB133111EBULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+#endif
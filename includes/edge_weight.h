@@ -0,0 +1,147 @@
+#ifndef EDGE_WEIGHT_H
+#define EDGE_WEIGHT_H
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/*
+ * Storage type of the threshold consensus edge weights and disagreement
+ * counts, chosen at build time with -DCONSENSUS_WEIGHT_TYPE=double|float|fixed16.
+ * A threshold is converted once into the same representation and compared
+ * there. fixed16 stores the number of agreeing partitions, i.e. the weight
+ * in units of 1/k, so the comparison is an exact integer one. The smaller
+ * types also keep 16-bit counts and need k < 65535.
+ *
+ * The iterative consensus modes sum the partition weights of the partition
+ * file into the igraph weight attribute instead, through a codec made by
+ * FromPartitionWeights. It rounds every sum, the all-agree weight and the
+ * threshold to the same type, so those modes settle edges and apply
+ * thresholds the way the threshold engine does. The attribute itself stays a
+ * double holding the rounded value. fixed16 counts in units of a scale:
+ * whole partition weights summing to at most 65535 keep a scale of 1 and
+ * stay exact, anything else is quantized so that the sum of all partition
+ * weights is 65535 units.
+ */
+#if defined(CONSENSUS_WEIGHT_FIXED16)
+using EdgeWeight = uint16_t;
+using DisagreementCount = uint16_t;
+#elif defined(CONSENSUS_WEIGHT_FLOAT)
+using EdgeWeight = float;
+using DisagreementCount = uint16_t;
+#else
+using EdgeWeight = double;
+using DisagreementCount = int;
+#endif
+
+class EdgeWeightCodec {
+    public:
+        EdgeWeightCodec(int num_partitions) : num_partitions(num_partitions) {
+            if(num_partitions >= std::numeric_limits<DisagreementCount>::max()) {
+                throw std::invalid_argument("this build stores edge weights in 16 bits and needs fewer than " + std::to_string(std::numeric_limits<DisagreementCount>::max()) + " partitions");
+            }
+        };
+
+        inline EdgeWeight FromDisagreements(int num_disagreements) const {
+#if defined(CONSENSUS_WEIGHT_FIXED16)
+            return this->num_partitions - num_disagreements;
+#elif defined(CONSENSUS_WEIGHT_FLOAT)
+            return static_cast<float>(this->num_partitions - num_disagreements) / this->num_partitions;
+#else
+            // repeated subtraction is how the weights have always been computed, ties at a threshold depend on it
+            double edge_weight = 1.0;
+            for(int i = 0; i < num_disagreements; i ++) {
+                edge_weight -= ((double)1/this->num_partitions);
+            }
+            return edge_weight;
+#endif
+        }
+
+        // an edge survives a threshold iff its weight is >= the converted threshold
+        inline EdgeWeight FromThreshold(double threshold) const {
+#if defined(CONSENSUS_WEIGHT_FIXED16)
+            // the tolerance keeps thresholds like 0.7 with k = 10 at 7 agreeing partitions instead of 8
+            double min_agreements = std::ceil(threshold * this->num_partitions - 1e-9);
+            return std::max(0.0, std::min(min_agreements, static_cast<double>(this->num_partitions + 1)));
+#elif defined(CONSENSUS_WEIGHT_FLOAT)
+            return static_cast<float>(threshold);
+#else
+            return threshold;
+#endif
+        }
+
+        // codec of the iterative modes for the partition weights of the partition file
+        static EdgeWeightCodec FromPartitionWeights(const std::vector<double>& weight_vector) {
+            EdgeWeightCodec weight_codec;
+            weight_codec.num_partitions = weight_vector.size();
+#if defined(CONSENSUS_WEIGHT_FIXED16)
+            double weight_sum = 0;
+            bool whole_weights = true;
+            for(double partition_weight : weight_vector) {
+                if(partition_weight < 0) {
+                    throw std::invalid_argument("this build stores edge weights as 16-bit integers and needs non-negative partition weights");
+                }
+                whole_weights = whole_weights && partition_weight == std::floor(partition_weight);
+                weight_sum += partition_weight;
+            }
+            if(!whole_weights || weight_sum > FixedMaxUnits()) {
+                weight_codec.weight_scale = weight_sum / FixedMaxUnits();
+            }
+#else
+            (void) weight_vector;
+#endif
+            return weight_codec;
+        }
+
+        // adds one partition weight to an edge weight of the iterative modes
+        inline double AddWeight(double edge_weight, double partition_weight) const {
+#if defined(CONSENSUS_WEIGHT_FIXED16)
+            // partition weights are rounded down so that all of them together stay within 16 bits
+            double units = std::lround(edge_weight / this->weight_scale) + std::floor(partition_weight / this->weight_scale + 1e-9);
+            return std::min(units, FixedMaxUnits()) * this->weight_scale;
+#elif defined(CONSENSUS_WEIGHT_FLOAT)
+            return static_cast<float>(edge_weight) + static_cast<float>(partition_weight);
+#else
+            return edge_weight + partition_weight;
+#endif
+        }
+
+        // the voting multiplier of ensemble consensus
+        inline double ScaleWeight(double edge_weight, double multiplier) const {
+#if defined(CONSENSUS_WEIGHT_FIXED16)
+            double units = std::lround(edge_weight / this->weight_scale * multiplier);
+            return std::min(units, FixedMaxUnits()) * this->weight_scale;
+#elif defined(CONSENSUS_WEIGHT_FLOAT)
+            return static_cast<float>(edge_weight) * static_cast<float>(multiplier);
+#else
+            return edge_weight * multiplier;
+#endif
+        }
+
+        // an edge of the iterative modes survives iff its weight is >= the returned value
+        inline double FromWeightThreshold(double threshold, double max_weight) const {
+#if defined(CONSENSUS_WEIGHT_FIXED16)
+            double min_units = std::ceil(threshold * std::lround(max_weight / this->weight_scale) - 1e-9);
+            return std::max(0.0, std::min(min_units, FixedMaxUnits())) * this->weight_scale;
+#elif defined(CONSENSUS_WEIGHT_FLOAT)
+            return static_cast<float>(threshold) * static_cast<float>(max_weight);
+#else
+            return threshold * max_weight;
+#endif
+        }
+
+    private:
+        EdgeWeightCodec() = default;
+        static constexpr double FixedMaxUnits() {
+            return std::numeric_limits<uint16_t>::max();
+        }
+
+        int num_partitions = 0;
+        // weight of one fixed16 unit in the iterative modes
+        double weight_scale = 1;
+};
+
+#endif
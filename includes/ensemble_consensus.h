@@ -2,6 +2,7 @@
 #define ENSEMBLE_CONSENSUS_H
 
 #include "consensus.h"
+#include "edge_weight.h"
 
 class EnsembleConsensus : public Consensus {
     public:
@@ -27,11 +28,24 @@ class EnsembleConsensus : public Consensus {
                           final_clustering_flag(final_clustering_flag) {
         };
         int main();
+        std::vector<double> GetConvergenceSettings() const override {
+            return {static_cast<double>(this->delta_convergence_flag), this->delta};
+        }
 
         bool CheckConvergence(igraph_t* lhs_graph_ptr, igraph_t* rhs_graph_ptr, double max_weight, int iter_count);
         bool CheckConvergence(igraph_t* graph_ptr, double max_weight, int iter_count);
         bool CheckConvergence(igraph_t* lhs_graph_ptr, igraph_t* rhs_graph_ptr, int iter_count);
 
+        static inline void GetClusterSizes(const std::map<int, int>& clustering, std::pmr::vector<int>& cluster_sizes) {
+            // voting only asks whether a cluster is a singleton, so the sizes stand in for the cluster to nodes map
+            for(auto const& [node_id, cluster_id] : clustering) {
+                if(cluster_id >= static_cast<int>(cluster_sizes.size())) {
+                    cluster_sizes.resize(cluster_id + 1, 0);
+                }
+                cluster_sizes[cluster_id] ++;
+            }
+        }
+
     private:
         double delta;
         int max_iter;
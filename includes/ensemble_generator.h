@@ -0,0 +1,24 @@
+#ifndef ENSEMBLE_GENERATOR_H
+#define ENSEMBLE_GENERATOR_H
+
+#include "consensus.h"
+
+/*
+ * Computes the partitions for a range of rows of the partition file and
+ * writes each one to <shard-directory>/partition.<row>.ccmb, so one ensemble
+ * can be spread over the tasks of a SLURM array and combined with reduce.
+ */
+class EnsembleGenerator : public Consensus {
+    public:
+        EnsembleGenerator(std::string edgelist, std::string partition_file, int first_partition, int last_partition, int num_partitions, int num_processors, std::string shard_directory, std::string log_file, int log_level) : Consensus(edgelist, partition_file, "", 1.0, 0, num_partitions, num_processors, shard_directory, log_file, log_level), first_partition(first_partition), last_partition(last_partition) {
+        };
+        int main();
+
+        static std::string GetShardFile(std::string shard_directory, int partition_index);
+
+    private:
+        int first_partition;
+        int last_partition;
+};
+
+#endif
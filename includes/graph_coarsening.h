@@ -0,0 +1,49 @@
+#ifndef GRAPH_COARSENING_H
+#define GRAPH_COARSENING_H
+#include <cstdint>
+#include <map>
+#include <vector>
+#include <omp.h>
+
+#include <igraph/igraph.h>
+
+#include "union_find.h"
+
+/*
+ * Contracts the components of edges whose "weight" reached max_weight into
+ * supernodes. Parallel edges between two supernodes are merged and edges
+ * inside a supernode become a self loop, with the number of original edges
+ * kept in the "coarse_weight" edge attribute and the number of original nodes
+ * in the "coarse_size" vertex attribute so the clustering algorithms see the
+ * same degrees and CPM sizes as on the original graph.
+ */
+class GraphCoarsening {
+    public:
+        GraphCoarsening(igraph_t* graph_ptr, double max_weight);
+        ~GraphCoarsening() {
+            igraph_destroy(&this->coarse_graph);
+        }
+        GraphCoarsening(const GraphCoarsening&) = delete;
+        GraphCoarsening& operator=(const GraphCoarsening&) = delete;
+
+        igraph_t* GetCoarseGraph() {
+            return &this->coarse_graph;
+        }
+        int NumCoarseNodes() const {
+            return this->num_coarse_nodes;
+        }
+        // maps a partition of the supernodes back onto every original node with an edge
+        std::map<int, int> ExpandPartition(const std::map<int, int>& coarse_partition_map) const;
+
+        static inline bool IsCoarseGraph(const igraph_t* graph_ptr) {
+            return igraph_cattribute_has_attr(graph_ptr, IGRAPH_ATTRIBUTE_EDGE, "coarse_weight");
+        }
+
+    private:
+        igraph_t coarse_graph;
+        int num_coarse_nodes;
+        std::vector<int> coarse_node_ids;
+        std::vector<char> has_edge;
+};
+
+#endif
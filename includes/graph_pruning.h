@@ -0,0 +1,61 @@
+#ifndef GRAPH_PRUNING_H
+#define GRAPH_PRUNING_H
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <vector>
+#include <omp.h>
+
+#include <igraph/igraph.h>
+
+#include "csr_graph.h"
+
+/*
+ * Peels the parts of the graph whose clustering is decided by their
+ * attachment point before any partition is computed. Degree-1 nodes are
+ * removed round by round until only the 2-core is left and, optionally,
+ * maximal paths of degree-2 nodes between two core nodes that are not
+ * adjacent are replaced by a single edge between their ends. Paths that close
+ * a cycle, like the third node of a triangle or two paths between the same
+ * ends, are kept since they are what holds their ends together. Vertex ids do not change, peeled nodes just
+ * lose their edges.
+ *
+ * Reattachment rule:
+ *  - a path node joins the cluster of its ends if both ends share one and
+ *    otherwise the cluster of the nearer end, the first end on ties
+ *  - a tree node joins the cluster of the neighbour it hung from when it was
+ *    peeled, so a whole pendant tree follows its core node
+ *  - a tree that was peeled completely (a tree component) becomes a cluster
+ *  - nodes whose anchor has no cluster stay without one
+ */
+class GraphPruning {
+    public:
+        GraphPruning(igraph_t* graph_ptr, bool peel_paths);
+        std::map<int, int> Reattach(const std::map<int, int>& core_partition_map) const;
+
+        int64_t num_tree_nodes = 0;
+        int64_t num_path_nodes = 0;
+
+    private:
+        struct Path {
+            int first_end;
+            int second_end;
+            std::vector<int> nodes;
+        };
+
+        void PeelTrees(const CSRGraph& graph);
+        void PeelPaths(const CSRGraph& graph);
+
+        static constexpr int tree_root = -1;
+        static constexpr int not_peeled = -2;
+
+        int num_nodes;
+        std::vector<std::atomic<int>> degree;
+        std::vector<char> peeled;
+        // neighbour a tree node hung from, tree_root for the last node of a tree component
+        std::vector<int> anchor;
+        std::vector<std::vector<int>> peeling_rounds;
+        std::vector<Path> paths;
+};
+
+#endif
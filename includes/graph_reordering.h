@@ -0,0 +1,40 @@
+#ifndef GRAPH_REORDERING_H
+#define GRAPH_REORDERING_H
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include <omp.h>
+
+#include <igraph/igraph.h>
+
+#include "csr_graph.h"
+#include "label_propagation.h"
+
+/*
+ * Relabels the vertices of a freshly loaded graph so that vertices that are
+ * close in the graph are also close in memory, and rebuilds it with its edges
+ * sorted by their smaller endpoint. The permutation is kept so partitions
+ * found on the reordered graph can be written with the input node ids.
+ *  - degree: by decreasing degree, hubs first
+ *  - rcm: reverse Cuthill-McKee, a breadth first order per component
+ *  - community: grouped by a label propagation clustering, similar in spirit
+ *    to Rabbit order but without its incremental aggregation
+ */
+class GraphReordering {
+    public:
+        GraphReordering(igraph_t* graph_ptr, std::string ordering);
+        std::map<int, int> RestoreOrder(const std::map<int, int>& partition_map) const;
+
+    private:
+        std::vector<int> DegreeOrder(const CSRGraph& graph) const;
+        std::vector<int> ReverseCuthillMcKeeOrder(const CSRGraph& graph) const;
+        std::vector<int> CommunityOrder(CSRGraph& graph) const;
+        void Rebuild(igraph_t* graph_ptr, const CSRGraph& graph) const;
+
+        // original_ids[new id] is the input id of a vertex and new_ids the inverse
+        std::vector<int> original_ids;
+        std::vector<int> new_ids;
+};
+
+#endif
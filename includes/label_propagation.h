@@ -0,0 +1,27 @@
+#ifndef LABEL_PROPAGATION_H
+#define LABEL_PROPAGATION_H
+#include <cstdint>
+#include <vector>
+#include <omp.h>
+
+#include "csr_graph.h"
+
+/*
+ * Weighted semi-synchronous label propagation. In every round a seeded hash
+ * picks half of the nodes, which all adopt the heaviest label around them as
+ * seen at the start of the round. Updating only half of the nodes at a time
+ * keeps synchronous updates from oscillating on bipartite structures while
+ * the result stays independent of the number of threads.
+ */
+class LabelPropagation {
+    public:
+        LabelPropagation(CSRGraph* graph_ptr, int seed) : graph_ptr(graph_ptr), seed(seed) {
+        };
+        std::vector<int> Run(int max_rounds = 30);
+
+    private:
+        CSRGraph* graph_ptr;
+        int seed;
+};
+
+#endif
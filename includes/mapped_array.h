@@ -0,0 +1,77 @@
+#ifndef MAPPED_ARRAY_H
+#define MAPPED_ARRAY_H
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/*
+ * Fixed size array in a file backed shared mapping for the out-of-core mode.
+ * The file is unlinked right after it is created so it disappears with the
+ * mapping, and it starts out zeroed. Pages of a range that was streamed
+ * through are handed back with Release, which keeps the resident set at the
+ * chunk being worked on while the kernel writes the rest back to the file.
+ */
+template<typename T>
+class MappedArray {
+    public:
+        MappedArray(std::string spill_directory, int64_t num_elements) : num_elements(num_elements) {
+            std::string spill_file = spill_directory + "/consensus_clustering.XXXXXX";
+            int spill_fd = mkstemp(spill_file.data());
+            if(spill_fd == -1) {
+                throw std::runtime_error("could not create a spill file in " + spill_directory);
+            }
+            unlink(spill_file.c_str());
+            this->mapping_size = std::max<size_t>(1, num_elements * sizeof(T));
+            if(ftruncate(spill_fd, this->mapping_size) != 0) {
+                close(spill_fd);
+                throw std::runtime_error("could not size a spill file in " + spill_directory);
+            }
+            void* mapping = mmap(NULL, this->mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, spill_fd, 0);
+            close(spill_fd);
+            if(mapping == MAP_FAILED) {
+                throw std::runtime_error("could not map a spill file in " + spill_directory);
+            }
+            this->elements = static_cast<T*>(mapping);
+        };
+        ~MappedArray() {
+            munmap(this->elements, this->mapping_size);
+        }
+        MappedArray(const MappedArray&) = delete;
+        MappedArray& operator=(const MappedArray&) = delete;
+
+        inline T& operator[](int64_t index) {
+            return this->elements[index];
+        }
+        inline const T& operator[](int64_t index) const {
+            return this->elements[index];
+        }
+        inline T* Data() {
+            return this->elements;
+        }
+        inline int64_t Size() const {
+            return this->num_elements;
+        }
+
+        // drops the whole pages inside [first, last) from the resident set, their contents stay in the file
+        void Release(int64_t first, int64_t last) {
+            const uintptr_t page_size = sysconf(_SC_PAGESIZE);
+            uintptr_t range_begin = (reinterpret_cast<uintptr_t>(this->elements + first) + page_size - 1) / page_size * page_size;
+            uintptr_t range_end = reinterpret_cast<uintptr_t>(this->elements + last) / page_size * page_size;
+            if(range_begin < range_end) {
+                msync(reinterpret_cast<void*>(range_begin), range_end - range_begin, MS_ASYNC);
+                madvise(reinterpret_cast<void*>(range_begin), range_end - range_begin, MADV_DONTNEED);
+            }
+        }
+
+    private:
+        int64_t num_elements;
+        size_t mapping_size;
+        T* elements;
+};
+
+#endif
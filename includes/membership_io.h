@@ -0,0 +1,76 @@
+#ifndef MEMBERSHIP_IO_H
+#define MEMBERSHIP_IO_H
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <map>
+
+/*
+ * Compact binary membership files. The layout is
+ *   char[4]  magic "CCMB"
+ *   uint32_t version
+ *   uint32_t flags (varint_flag, zstd_flag)
+ *   uint32_t reserved
+ *   uint64_t number of nodes
+ *   uint64_t id map reference, identity_id_map when label i belongs to node i
+ *            and otherwise a hash of the node names in graph vertex order
+ *   uint64_t payload size in bytes
+ *   payload  uint32_t label per node, no_membership for nodes without a cluster.
+ *            With varint_flag every label + 1 is LEB128 encoded (0 for
+ *            no_membership) and with zstd_flag the payload is one zstd frame.
+ */
+class MembershipIO {
+    public:
+        static constexpr uint32_t no_membership = UINT32_MAX;
+        static constexpr uint32_t version = 2;
+        static constexpr uint32_t varint_flag = 1;
+        static constexpr uint32_t zstd_flag = 2;
+        static constexpr uint64_t identity_id_map = 0;
+        // node ids are 32-bit everywhere else, so larger counts can only come from a corrupt header
+        static constexpr uint64_t max_num_nodes = uint64_t(1) << 32;
+
+        static bool WriteBinaryMembership(std::string membership_file, const std::vector<uint32_t>& labels, uint32_t flags = 0, uint64_t id_map = MembershipIO::identity_id_map);
+        // LabelVector is std::vector<uint32_t> or PlacedVector<uint32_t>
+        template<typename LabelVector>
+        static bool ReadBinaryMembership(std::string membership_file, LabelVector& labels, uint64_t* id_map = nullptr);
+        static bool IsBinaryMembershipFile(std::string membership_file);
+
+        // flags for the binary --output-format values, text has no flags and is handled by the callers
+        static inline uint32_t GetOutputFormatFlags(const std::string& output_format) {
+            if(output_format == "binary-varint") {
+                return MembershipIO::varint_flag;
+            } else if(output_format == "binary-zstd") {
+                return MembershipIO::varint_flag | MembershipIO::zstd_flag;
+            }
+            return 0;
+        }
+
+        static inline bool HasZstd() {
+#ifdef CONSENSUS_HAVE_ZSTD
+            return true;
+#else
+            return false;
+#endif
+        }
+
+        static inline std::vector<uint32_t> PartitionMapToLabels(const std::map<int, int>& partition_map, int64_t num_nodes) {
+            std::vector<uint32_t> labels(num_nodes, MembershipIO::no_membership);
+            for(auto const& [node_id, cluster_id] : partition_map) {
+                labels[node_id] = cluster_id;
+            }
+            return labels;
+        }
+
+        static inline std::map<int, int> LabelsToPartitionMap(const std::vector<uint32_t>& labels) {
+            std::map<int, int> partition_map;
+            for(size_t node_id = 0; node_id < labels.size(); node_id ++) {
+                if(labels[node_id] != MembershipIO::no_membership) {
+                    partition_map.emplace_hint(partition_map.end(), node_id, labels[node_id]);
+                }
+            }
+            return partition_map;
+        }
+};
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef MEMBERSHIP_RING_BUFFER_H
+#define MEMBERSHIP_RING_BUFFER_H
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+/*
+ * Bounded ring buffer of memberships in an anonymous shared mapping, created
+ * before the worker processes are forked so every process sees the same
+ * memory. Worker processes claim partition rows from a shared counter and
+ * push one uint32_t label per node, the parent is the only consumer. Slots
+ * carry a sequence number as in Vyukov's bounded queue, so a producer waits
+ * for its slot to be drained instead of taking a lock. A producer that dies
+ * between reserving a position and filling its slot leaves a hole the
+ * consumer would wait on forever, so the parent gives up on the whole run
+ * when a worker process exits abnormally.
+ */
+class MembershipRingBuffer {
+    public:
+        MembershipRingBuffer(int num_slots, int64_t num_nodes, int first_partition);
+        ~MembershipRingBuffer();
+        MembershipRingBuffer(const MembershipRingBuffer&) = delete;
+        MembershipRingBuffer& operator=(const MembershipRingBuffer&) = delete;
+
+        int ClaimPartition() {
+            return this->header->next_partition.fetch_add(1, std::memory_order_relaxed);
+        }
+        void Push(int partition_index, const std::map<int, int>& partition_map);
+        bool TryPop(int& partition_index, std::vector<uint32_t>& labels);
+        // partition cache hits of the worker processes, which the parent cannot see in its own cache object
+        void AddCacheHits(int num_hits) {
+            this->header->num_cache_hits.fetch_add(num_hits, std::memory_order_relaxed);
+        }
+        int NumCacheHits() const {
+            return this->header->num_cache_hits.load(std::memory_order_relaxed);
+        }
+
+    private:
+        struct Header {
+            std::atomic<uint64_t> enqueue_position;
+            std::atomic<int> next_partition;
+            std::atomic<int> num_cache_hits;
+            uint64_t dequeue_position;
+        };
+        struct SlotHeader {
+            std::atomic<uint64_t> sequence;
+            int partition_index;
+        };
+        static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<int>::is_always_lock_free, "atomics shared between processes have to be lock free");
+
+        inline SlotHeader* GetSlot(uint64_t position) const {
+            return reinterpret_cast<SlotHeader*>(this->slots + (position % this->num_slots) * this->slot_size);
+        }
+        inline uint32_t* GetSlotLabels(SlotHeader* slot) const {
+            return reinterpret_cast<uint32_t*>(reinterpret_cast<char*>(slot) + sizeof(SlotHeader));
+        }
+
+        int num_slots;
+        int64_t num_nodes;
+        size_t slot_size;
+        size_t mapping_size;
+        void* mapping;
+        Header* header;
+        char* slots;
+};
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef MEMORY_PLACEMENT_H
+#define MEMORY_PLACEMENT_H
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+#include <sched.h>
+
+/*
+ * Placement of the large per-edge and per-node arrays. Their pages are
+ * first-touched by the OpenMP team with the same static schedule the kernels
+ * use, so on a multi-socket node every thread finds its share of the array on
+ * its own NUMA node instead of wherever the loading thread ran. With
+ * huge_pages_flag the mappings are also 2MB aligned and marked for
+ * transparent huge pages to cut the TLB misses of the random endpoint reads.
+ * PinThreads fixes the OpenMP threads to cores in contiguous blocks per NUMA
+ * node so that the static chunks keep running where they were touched.
+ */
+class MemoryPlacement {
+    public:
+        static void* Allocate(size_t num_bytes);
+        static void Deallocate(void* pointer, size_t num_bytes);
+        static std::vector<std::vector<int>> GetNodeCpus();
+        static int PinThreads(int num_threads);
+        static void UnpinThisThread();
+
+        static inline bool huge_pages_flag = false;
+        static constexpr size_t huge_page_bytes = size_t(1) << 21;
+        // smaller arrays fit in a few pages and go through the regular allocator
+        static constexpr size_t min_placed_bytes = huge_page_bytes;
+
+    private:
+        static inline bool pinned_flag = false;
+        static inline cpu_set_t unpinned_cpus;
+};
+
+template<typename T>
+class PlacedAllocator {
+    public:
+        using value_type = T;
+
+        PlacedAllocator() = default;
+        template<typename U>
+        PlacedAllocator(const PlacedAllocator<U>&) {
+        };
+
+        T* allocate(size_t num_elements) {
+            if(num_elements * sizeof(T) < MemoryPlacement::min_placed_bytes) {
+                return static_cast<T*>(::operator new(num_elements * sizeof(T)));
+            }
+            return static_cast<T*>(MemoryPlacement::Allocate(num_elements * sizeof(T)));
+        }
+        void deallocate(T* pointer, size_t num_elements) {
+            if(num_elements * sizeof(T) < MemoryPlacement::min_placed_bytes) {
+                ::operator delete(pointer);
+                return;
+            }
+            MemoryPlacement::Deallocate(pointer, num_elements * sizeof(T));
+        }
+
+        template<typename U>
+        bool operator==(const PlacedAllocator<U>&) const {
+            return true;
+        }
+};
+
+template<typename T>
+using PlacedVector = std::vector<T, PlacedAllocator<T>>;
+
+#endif
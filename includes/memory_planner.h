@@ -0,0 +1,60 @@
+#ifndef MEMORY_PLANNER_H
+#define MEMORY_PLANNER_H
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * Execution plan for a --max-memory budget. The plans differ in how many
+ * partitions are clustered at the same time, whether the threshold ensemble
+ * is kept as one membership per partition or streamed into per-edge
+ * disagreement counts as the partitions finish, and whether voting keeps the
+ * cluster to nodes map of every partition or only its cluster sizes. All of
+ * them produce the same output.
+ */
+struct MemoryPlan {
+    int num_workers = 0;
+    bool materialised_memberships = true;
+    bool voting = false;
+    bool voting_maps = true;
+    int64_t predicted_peak_bytes = 0;
+
+    std::string Describe() const;
+};
+
+/*
+ * Estimates the peak of every phase (loaded graph, ensemble, accumulation)
+ * from the number of nodes, edges and partitions and the algorithms in the
+ * partition file, and picks the fastest plan under the budget. The sizes
+ * are the payloads of the igraph, CSR and std::map structures involved, not
+ * a measurement, so the measured peak is logged next to the prediction.
+ */
+class MemoryPlanner {
+    public:
+        MemoryPlanner(int64_t num_nodes, int64_t num_edges, int num_partitions, const std::vector<std::string>& algorithm_vector, int num_processors) : num_nodes(num_nodes), num_edges(num_edges), num_partitions(num_partitions), algorithm_vector(algorithm_vector), num_processors(num_processors) {
+        };
+        MemoryPlan Plan(int64_t max_memory, bool iterative, bool streaming_possible, bool voting) const;
+        int64_t PredictPeak(const MemoryPlan& plan, bool iterative, bool voting) const;
+
+        static int64_t GetMeasuredPeakBytes();
+        // the summed peak of one batch of forked workers, which run next to the main process
+        static void RecordWorkerPeakBytes(int64_t worker_peak_bytes) {
+            MemoryPlanner::worker_peak_bytes = std::max(MemoryPlanner::worker_peak_bytes, worker_peak_bytes);
+        }
+
+    private:
+        int64_t GetGraphBytes() const;
+        int64_t GetWorkerBytes(const std::string& algorithm) const;
+
+        int64_t num_nodes;
+        int64_t num_edges;
+        int num_partitions;
+        std::vector<std::string> algorithm_vector;
+        int num_processors;
+        static constexpr int64_t map_entry_bytes = 48;
+        static constexpr int64_t pointer_bytes = 8;
+        static inline int64_t worker_peak_bytes = 0;
+};
+
+#endif
@@ -2,6 +2,7 @@
 #define MULTI_RESOLUTION_CONSENSUS_H
 
 #include "consensus.h"
+#include "edge_weight.h"
 
 class MultiResolutionConsensus : public Consensus {
     public:
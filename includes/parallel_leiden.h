@@ -0,0 +1,46 @@
+#ifndef PARALLEL_LEIDEN_H
+#define PARALLEL_LEIDEN_H
+#include <cstdint>
+#include <vector>
+#include <omp.h>
+
+#include "csr_graph.h"
+
+/*
+ * Shared memory Leiden with parallel local moving, refinement and aggregation.
+ * Moves are decided against a snapshot of the community totals and only a
+ * seeded hash selected half of the vertices may move in each round, so the
+ * result only depends on the seed and not on the number of threads as long
+ * as the edge weights are integral (every graph handed in by GetCommunities).
+ */
+class ParallelLeiden {
+    public:
+        enum class Quality { CPM, Modularity };
+
+        ParallelLeiden(CSRGraph* graph_ptr, Quality quality, double resolution, int seed) : graph_ptr(graph_ptr), quality(quality), resolution(resolution), seed(seed) {
+        };
+        std::vector<int> Run(int num_iter = 2);
+
+    private:
+        std::vector<int> RunLevels(const std::vector<int>& initial_membership);
+        bool MoveNodes(const CSRGraph& graph, std::vector<int>& membership);
+        std::vector<int> RefinePartition(const CSRGraph& graph, const std::vector<int>& membership);
+        CSRGraph Aggregate(const CSRGraph& graph, const std::vector<int>& refined_membership, int num_refined);
+        static int Renumber(std::vector<int>& membership);
+
+        inline double Gain(double edges_to_community, double node_size, double node_strength, double community_size, double community_strength, double total_strength) const {
+            if(this->quality == Quality::CPM) {
+                return edges_to_community - this->resolution * node_size * community_size;
+            }
+            return edges_to_community - this->resolution * node_strength * community_strength / total_strength;
+        }
+
+        CSRGraph* graph_ptr;
+        Quality quality;
+        double resolution;
+        int seed;
+        uint64_t round_counter = 0;
+        static constexpr int max_rounds = 32;
+};
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef PARTITION_CACHE_H
+#define PARTITION_CACHE_H
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <map>
+#include <filesystem>
+
+#include <igraph/igraph.h>
+
+#include "membership_io.h"
+
+/*
+ * On-disk cache of clusterings keyed by a hash of the graph (vertex count,
+ * the edges in order, since the clustering depends on the edge order, and
+ * the supernode sizes and edge multiplicities of coarse graphs) plus
+ * the algorithm, its parameter and the seed. Entries are binary membership
+ * files written to a temporary name and renamed so concurrent jobs sharing a
+ * cache directory never read a partial entry.
+ */
+class PartitionCache {
+    public:
+        PartitionCache(std::string cache_directory, igraph_t* graph_ptr) : cache_directory(cache_directory), num_nodes(igraph_vcount(graph_ptr)), graph_hash(PartitionCache::HashGraph(graph_ptr)) {
+            std::filesystem::create_directories(this->cache_directory);
+        };
+        bool Lookup(std::string algorithm, double clustering_parameter, int seed, std::map<int, int>& partition_map);
+        void Store(std::string algorithm, double clustering_parameter, int seed, const std::map<int, int>& partition_map);
+
+        static uint64_t HashGraph(igraph_t* graph_ptr);
+
+        std::atomic<int> num_hits{0};
+
+    private:
+        std::string GetEntryFile(std::string algorithm, double clustering_parameter, int seed);
+
+        std::string cache_directory;
+        int64_t num_nodes;
+        uint64_t graph_hash;
+};
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef PHASE_METRICS_H
+#define PHASE_METRICS_H
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Per-phase metrics written as one JSON object per line next to the log
+ * (<log-file>.metrics.jsonl). A Phase records its wall and CPU time when it
+ * goes out of scope, together with the iteration it started in and whichever
+ * edge counters were filled in. Every line goes out in a single write to a
+ * file opened for appending, so worker threads and forked worker processes
+ * can record their partitions into the same file without a lock.
+ *
+ * edges_processed is the number of edges a phase takes as input, counted
+ * once per partition it folds in, whether it reads all of them or, like the
+ * in-memory threshold sweep, only the ones that change its result.
+ *
+ * For profiling a single phase, CONSENSUS_PERF_PHASE names a phase and
+ * CONSENSUS_PERF_CTL_FD and CONSENSUS_PERF_ACK_FD the control and ack
+ * descriptors of `perf stat -D -1 --control fd:<ctl>,<ack>`. The counters
+ * are then enabled only while phases of that name run.
+ */
+class PhaseMetrics {
+    public:
+        class Phase {
+            public:
+                // worker threads measure the CPU time of their OpenMP team, forked workers and everything else
+                // the CPU time of the process
+                Phase(std::string name, int partition = -1, bool worker_flag = false);
+                ~Phase();
+                // records the phase now instead of at the end of the scope
+                void Finish();
+                Phase(const Phase&) = delete;
+                Phase& operator=(const Phase&) = delete;
+
+                int64_t edges_processed = -1;
+                int64_t edges_surviving = -1;
+                int64_t unsettled_edges = -1;
+
+            private:
+                std::string name;
+                int iteration;
+                int partition;
+                bool team_flag;
+                std::chrono::steady_clock::time_point start_time;
+                double start_cpu_seconds;
+                bool finished_flag = false;
+        };
+
+        static void Open(std::string metrics_file);
+        static void Close();
+        static inline void SetIteration(int iteration) {
+            PhaseMetrics::current_iteration = iteration;
+        }
+
+    private:
+        static double GetCpuSeconds(clockid_t cpu_clock);
+        static double GetTeamCpuSeconds();
+        static void ControlPerf(std::string command);
+
+        static inline int metrics_fd = -1;
+        static inline std::atomic<int> current_iteration = -1;
+        static inline std::chrono::steady_clock::time_point open_time;
+        static inline pid_t open_pid = -1;
+        static inline std::string perf_phase;
+        static inline int perf_ctl_fd = -1;
+        static inline int perf_ack_fd = -1;
+};
+
+#endif
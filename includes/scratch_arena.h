@@ -0,0 +1,116 @@
+#ifndef SCRATCH_ARENA_H
+#define SCRATCH_ARENA_H
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+/*
+ * Per-thread monotonic arena for the scratch structures of an iteration or of
+ * a partition. Allocating only bumps a pointer and nothing is freed until the
+ * outermost Scope on the thread ends, which rewinds the whole arena at once.
+ * Whatever had to come from the heap during a round is folded into the arena's
+ * own buffer for the next one, up to max_buffer_bytes, so once the first round
+ * has set the high water mark the scratch structures stop calling the
+ * allocator. A thread leases its arena from a process-wide pool and hands it
+ * back when it exits, so the worker threads StartWorkers creates for every
+ * iteration pick up the grown buffers of the previous ones. A Scope has to be
+ * declared before the containers that use its resource.
+ */
+class ScratchArena {
+    public:
+        class Scope {
+            public:
+                Scope() : arena(ScratchArena::ForThisThread()) {
+                    this->arena.depth ++;
+                };
+                ~Scope() {
+                    if(-- this->arena.depth == 0) {
+                        this->arena.Rewind();
+                    }
+                }
+                Scope(const Scope&) = delete;
+                Scope& operator=(const Scope&) = delete;
+
+                inline std::pmr::memory_resource* Resource() {
+                    return &*this->arena.resource;
+                }
+
+            private:
+                ScratchArena& arena;
+        };
+
+        static inline ScratchArena& ForThisThread() {
+            thread_local Lease lease;
+            return *lease.arena;
+        }
+
+    private:
+        class Lease {
+            public:
+                Lease() {
+                    std::lock_guard<std::mutex> pool_lock(ScratchArena::pool_mutex);
+                    if(ScratchArena::pool.empty()) {
+                        this->arena.reset(new ScratchArena());
+                    } else {
+                        this->arena = std::move(ScratchArena::pool.back());
+                        ScratchArena::pool.pop_back();
+                    }
+                };
+                ~Lease() {
+                    std::lock_guard<std::mutex> pool_lock(ScratchArena::pool_mutex);
+                    ScratchArena::pool.push_back(std::move(this->arena));
+                }
+
+                std::unique_ptr<ScratchArena> arena;
+        };
+
+        // heap fallback of the arena that remembers how much it handed out during the current round
+        class OverflowResource : public std::pmr::memory_resource {
+            public:
+                size_t num_bytes = 0;
+
+            private:
+                void* do_allocate(size_t bytes, size_t alignment) override {
+                    this->num_bytes += bytes;
+                    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+                }
+                void do_deallocate(void* pointer, size_t bytes, size_t alignment) override {
+                    std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+                }
+                bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+                    return this == &other;
+                }
+        };
+
+        ScratchArena() : buffer(new std::byte[ScratchArena::initial_buffer_bytes]), buffer_bytes(ScratchArena::initial_buffer_bytes) {
+            this->resource.emplace(this->buffer.get(), this->buffer_bytes, &this->overflow);
+        };
+
+        void Rewind() {
+            this->resource.reset();
+            // the new buffer is left uninitialised, and rounds larger than the cap keep some of their scratch on the heap
+            size_t grown_bytes = std::min(this->buffer_bytes + this->overflow.num_bytes, ScratchArena::max_buffer_bytes);
+            if(grown_bytes > this->buffer_bytes) {
+                this->buffer.reset(new std::byte[grown_bytes]);
+                this->buffer_bytes = grown_bytes;
+            }
+            this->overflow.num_bytes = 0;
+            this->resource.emplace(this->buffer.get(), this->buffer_bytes, &this->overflow);
+        }
+
+        std::unique_ptr<std::byte[]> buffer;
+        size_t buffer_bytes;
+        OverflowResource overflow;
+        std::optional<std::pmr::monotonic_buffer_resource> resource;
+        int depth = 0;
+        static constexpr size_t initial_buffer_bytes = size_t(1) << 16;
+        static constexpr size_t max_buffer_bytes = size_t(1) << 26;
+        static inline std::mutex pool_mutex;
+        static inline std::vector<std::unique_ptr<ScratchArena>> pool;
+};
+
+#endif
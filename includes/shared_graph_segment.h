@@ -0,0 +1,76 @@
+#ifndef SHARED_GRAPH_SEGMENT_H
+#define SHARED_GRAPH_SEGMENT_H
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include <igraph/igraph.h>
+
+/*
+ * A loaded graph published in a named POSIX shared memory segment so later
+ * jobs on the same node attach to it instead of parsing the edge-list again.
+ * The first page is a header with a version and a key of the source
+ * edge-list. The edges follow on read-only pages as int32_t pairs in the edge
+ * order of the loaded graph, which the clusterings depend on.
+ *
+ * Every attached job holds a shared flock on the segment and the publisher
+ * holds an exclusive one until the edges are written, so the kernel drops
+ * the locks of jobs that die. A job that can take the exclusive lock when it
+ * detaches is the last one and unlinks the segment. Opening, publishing and
+ * unlinking a name are serialised by a flock on a separate lock segment, so a
+ * detaching job never unlinks a segment that was published after its own.
+ */
+class SharedGraphSegment {
+    public:
+        static constexpr uint32_t version = 2;
+
+        ~SharedGraphSegment();
+        SharedGraphSegment(const SharedGraphSegment&) = delete;
+        SharedGraphSegment& operator=(const SharedGraphSegment&) = delete;
+
+        // nullptr if there is no segment with this name or it was made from another edge-list
+        static std::unique_ptr<SharedGraphSegment> Attach(std::string name, uint64_t source_key);
+        // nullptr if another job published the segment first or it cannot be created
+        static std::unique_ptr<SharedGraphSegment> Publish(std::string name, uint64_t source_key, igraph_t* graph_ptr);
+        static uint64_t GetSourceKey(std::string edgelist, bool simplified);
+
+        void ToGraph(igraph_t* graph_ptr) const;
+        int64_t NumNodes() const {
+            return this->header->num_nodes;
+        }
+        int64_t NumEdges() const {
+            return this->header->num_edges;
+        }
+        // the endpoint pairs in the layout the threshold engine reads, so reduce runs on them without a copy
+        const int* Edges() const {
+            return reinterpret_cast<const int*>(this->data);
+        }
+
+    private:
+        struct Header {
+            char magic[4];
+            uint32_t version;
+            std::atomic<uint32_t> ready;
+            uint64_t source_key;
+            int64_t num_nodes;
+            int64_t num_edges;
+            uint64_t data_size;
+        };
+        static_assert(std::atomic<uint32_t>::is_always_lock_free, "atomics shared between processes have to be lock free");
+        static constexpr size_t header_size = 4096;
+
+        SharedGraphSegment(std::string segment_name, int segment_fd, Header* header, const char* data, size_t data_size) : segment_name(segment_name), segment_fd(segment_fd), header(header), data(data), data_size(data_size) {
+        };
+        static std::string GetSegmentName(std::string name);
+        static int LockName(std::string segment_name);
+        static void UnlockName(int lock_fd);
+
+        std::string segment_name;
+        int segment_fd;
+        Header* header;
+        const char* data;
+        size_t data_size;
+};
+
+#endif
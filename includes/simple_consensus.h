@@ -2,6 +2,7 @@
 #define SIMPLE_CONSENSUS_H
 
 #include "consensus.h"
+#include "edge_weight.h"
 
 class SimpleConsensus : public Consensus {
     public:
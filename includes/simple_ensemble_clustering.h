@@ -5,12 +5,16 @@
 
 class SimpleEnsembleClustering : public Consensus {
     public:
-        SimpleEnsembleClustering(std::string edgelist, float threshold, std::vector<std::string> clustering_files, std::vector<std::string> clustering_weights, std::string output_file, std::string log_file, int log_level) : Consensus(edgelist, threshold, output_file, log_file, log_level), clustering_files(clustering_files), clustering_weights(clustering_weights) {
+        SimpleEnsembleClustering(std::string edgelist, float threshold, std::vector<std::string> clustering_files, std::vector<std::string> clustering_weights, std::string output_file, std::string log_file, int log_level, bool streaming = false) : Consensus(edgelist, threshold, output_file, log_file, log_level), clustering_files(clustering_files), clustering_weights(clustering_weights), streaming(streaming) {
         };
         int main();
     private:
+        void AccumulateEdgeWeights(igraph_t* graph_ptr, ClusteringFileReader& clustering_file_reader, const std::vector<float>& float_custering_weights, igraph_vector_t* edge_weight_vector);
+        void StreamEdgeWeights(igraph_t* graph_ptr, ClusteringFileReader& clustering_file_reader, const std::vector<float>& float_custering_weights, igraph_vector_t* edge_weight_vector);
+
         std::vector<std::string> clustering_files;
         std::vector<std::string> clustering_weights;
+        bool streaming;
 };
 
 #endif
@@ -2,14 +2,62 @@
 #define THRESHOLD_CONSENSUS_H
 
 #include "consensus.h"
+#include "union_find.h"
+#include "edge_weight.h"
+#include "ensemble_generator.h"
 
 class ThresholdConsensus : public Consensus {
     public:
-        ThresholdConsensus(std::string edgelist, std::string partition_file, std::string final_algorithm, double threshold, double final_resolution, int num_partitions, int num_processors, std::string output_file, std::string log_file, int log_level) : Consensus(edgelist, partition_file, final_algorithm, threshold, final_resolution, num_partitions, num_processors, output_file, log_file, log_level) {
+        ThresholdConsensus(std::string edgelist, std::string partition_file, std::string final_algorithm, std::vector<double> thresholds, double final_resolution, int num_partitions, int num_processors, std::string output_file, std::string log_file, int log_level) : Consensus(edgelist, partition_file, final_algorithm, thresholds.front(), final_resolution, num_partitions, num_processors, output_file, log_file, log_level), thresholds(thresholds), weight_codec(num_partitions) {
         };
         int main();
+        void SetShardDirectory(std::string shard_directory) {
+            this->shard_directory = shard_directory;
+        }
+
+        static std::vector<double> ParseThresholds(const std::vector<std::string>& threshold_arguments);
+
+        // node ids are 32-bit like the partition maps, libleidenalg results and membership files they end up in,
+        // only the edge index width is picked per graph
+        using VertexIndex = int32_t;
+
+        static std::map<int, int> GetComponentsFromUnionFind(UnionFind<VertexIndex>& union_find) {
+            // components are numbered by their smallest node like igraph_connected_components, singletons are dropped
+            std::map<int, int> partition;
+            std::vector<int> root_to_component_id(union_find.NumNodes(), -1);
+            int number_of_components = 0;
+            for(VertexIndex node_id = 0; node_id < union_find.NumNodes(); node_id ++) {
+                if(union_find.ComponentSize(node_id) > 1) {
+                    VertexIndex root = union_find.Find(node_id);
+                    if(root_to_component_id[root] == -1) {
+                        root_to_component_id[root] = number_of_components ++;
+                    }
+                    partition[node_id] = root_to_component_id[root];
+                }
+            }
+            return partition;
+        }
+
     private:
+        std::string GetThresholdOutputFile(double current_threshold);
+        // a null graph_ptr runs reduce on the edges of the attached shared graph
+        template<typename EdgeIndex>
+        int RunInMemory(igraph_t* graph_ptr);
+        template<typename EdgeIndex>
+        int RunOutOfCore(igraph_t* graph_ptr);
+        template<typename EdgeIndex>
+        bool AccumulateShards(int64_t num_nodes, const VertexIndex* edge_endpoints, PlacedVector<DisagreementCount>& num_disagreements);
+        template<typename EdgeIndex>
+        static void GetEdgeEndpoints(igraph_t* graph_ptr, VertexIndex* edge_endpoints);
+        int64_t GetStreamingChunkSize(int64_t num_nodes);
+        static inline bool IsUnsettled(DisagreementCount num_disagreements, int num_partitions) {
+            // the partitions neither all kept nor all cut the edge
+            return num_disagreements > 0 && num_disagreements < num_partitions;
+        }
+        std::vector<double> thresholds;
+        EdgeWeightCodec weight_codec;
         std::vector<std::string> clustering_files;
+        std::string shard_directory;
 };
 
 #endif
@@ -0,0 +1,162 @@
+#ifndef UNION_FIND_H
+#define UNION_FIND_H
+#include <atomic>
+#include <vector>
+#include <omp.h>
+
+/*
+ * Union-find with path halving and union by size, used to grow connected
+ * components one edge at a time. VertexIndex is the node id type, which the
+ * threshold engine fixes at 32 bits.
+ */
+template<typename VertexIndex>
+class UnionFind {
+    public:
+        UnionFind(VertexIndex num_nodes) : parent(num_nodes), component_size(num_nodes, 1) {
+            for(VertexIndex node_id = 0; node_id < num_nodes; node_id ++) {
+                this->parent[node_id] = node_id;
+            }
+        };
+
+        inline VertexIndex Find(VertexIndex node_id) {
+            while(this->parent[node_id] != node_id) {
+                this->parent[node_id] = this->parent[this->parent[node_id]];
+                node_id = this->parent[node_id];
+            }
+            return node_id;
+        }
+
+        inline bool Union(VertexIndex lhs_node_id, VertexIndex rhs_node_id) {
+            VertexIndex lhs_root = this->Find(lhs_node_id);
+            VertexIndex rhs_root = this->Find(rhs_node_id);
+            if(lhs_root == rhs_root) {
+                return false;
+            }
+            if(this->component_size[lhs_root] < this->component_size[rhs_root]) {
+                std::swap(lhs_root, rhs_root);
+            }
+            this->parent[rhs_root] = lhs_root;
+            this->component_size[lhs_root] += this->component_size[rhs_root];
+            return true;
+        }
+
+        inline VertexIndex ComponentSize(VertexIndex node_id) {
+            return this->component_size[this->Find(node_id)];
+        }
+
+        inline VertexIndex NumNodes() const {
+            return this->parent.size();
+        }
+
+    private:
+        std::vector<VertexIndex> parent;
+        std::vector<VertexIndex> component_size;
+};
+
+/*
+ * Lock-free union-find for linking many edges from several threads. Roots are
+ * linked by CAS from the larger to the smaller node id and Find halves paths
+ * by CAS, so a parent never increases and every root is the smallest node of
+ * its component. That numbers the components exactly like
+ * igraph_connected_components, in order of their smallest node.
+ */
+class ConcurrentUnionFind {
+    public:
+        ConcurrentUnionFind(int num_nodes) : parent(num_nodes) {
+            #pragma omp parallel for schedule(static)
+            for(int node_id = 0; node_id < num_nodes; node_id ++) {
+                this->parent[node_id].store(node_id, std::memory_order_relaxed);
+            }
+        };
+
+        inline int Find(int node_id) {
+            while(true) {
+                int parent_id = this->parent[node_id].load(std::memory_order_relaxed);
+                if(parent_id == node_id) {
+                    return node_id;
+                }
+                int grandparent_id = this->parent[parent_id].load(std::memory_order_relaxed);
+                if(parent_id != grandparent_id) {
+                    // losing this race is fine, someone else already moved the node closer to its root
+                    this->parent[node_id].compare_exchange_weak(parent_id, grandparent_id, std::memory_order_relaxed);
+                }
+                node_id = grandparent_id;
+            }
+        }
+
+        inline void Union(int lhs_node_id, int rhs_node_id) {
+            while(true) {
+                int lhs_root = this->Find(lhs_node_id);
+                int rhs_root = this->Find(rhs_node_id);
+                if(lhs_root == rhs_root) {
+                    return;
+                }
+                if(lhs_root < rhs_root) {
+                    std::swap(lhs_root, rhs_root);
+                }
+                int expected_parent = lhs_root;
+                if(this->parent[lhs_root].compare_exchange_strong(expected_parent, rhs_root, std::memory_order_relaxed)) {
+                    return;
+                }
+                lhs_node_id = lhs_root;
+                rhs_node_id = rhs_root;
+            }
+        }
+
+        // must not run concurrently with Union, returns the number of components
+        int GetComponents(std::vector<int>& component_ids, std::vector<int>& component_sizes) {
+            int num_nodes = this->parent.size();
+            component_ids.resize(num_nodes);
+            int num_threads = omp_get_max_threads();
+            int num_components = 0;
+            std::vector<int> thread_num_roots(num_threads + 1, 0);
+            #pragma omp parallel num_threads(num_threads)
+            {
+                int thread_id = omp_get_thread_num();
+                int num_team_threads = omp_get_num_threads();
+                int block_begin = static_cast<int64_t>(num_nodes) * thread_id / num_team_threads;
+                int block_end = static_cast<int64_t>(num_nodes) * (thread_id + 1) / num_team_threads;
+                int num_roots = 0;
+                for(int node_id = block_begin; node_id < block_end; node_id ++) {
+                    component_ids[node_id] = this->Find(node_id);
+                    if(component_ids[node_id] == node_id) {
+                        num_roots ++;
+                    }
+                }
+                thread_num_roots[thread_id + 1] = num_roots;
+                #pragma omp barrier
+                #pragma omp single
+                {
+                    for(int i = 0; i < num_team_threads; i ++) {
+                        thread_num_roots[i + 1] += thread_num_roots[i];
+                    }
+                    num_components = thread_num_roots[num_team_threads];
+                }
+                int next_component_id = thread_num_roots[thread_id];
+                for(int node_id = block_begin; node_id < block_end; node_id ++) {
+                    if(component_ids[node_id] == node_id) {
+                        component_ids[node_id] = next_component_id ++;
+                    }
+                }
+                #pragma omp barrier
+                // the other nodes still hold their root, whose entry now holds the component id
+                for(int node_id = block_begin; node_id < block_end; node_id ++) {
+                    if(this->parent[node_id].load(std::memory_order_relaxed) != node_id) {
+                        component_ids[node_id] = component_ids[component_ids[node_id]];
+                    }
+                }
+            }
+            component_sizes.assign(num_components, 0);
+            #pragma omp parallel for schedule(static)
+            for(int node_id = 0; node_id < num_nodes; node_id ++) {
+                #pragma omp atomic
+                component_sizes[component_ids[node_id]] ++;
+            }
+            return num_components;
+        }
+
+    private:
+        std::vector<std::atomic<int>> parent;
+};
+
+#endif
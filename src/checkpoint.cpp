@@ -0,0 +1,227 @@
+#include "checkpoint.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <unistd.h>
+
+namespace {
+    struct CheckpointHeader {
+        char magic[4];
+        uint32_t version;
+        uint64_t configuration_hash;
+        uint64_t iteration;
+        uint64_t payload_size;
+        uint64_t checksum;
+    };
+
+    uint64_t Checksum(const std::vector<char>& payload) {
+        uint64_t checksum = 0xcbf29ce484222325ULL;
+        for(char byte : payload) {
+            checksum = (checksum ^ static_cast<uint8_t>(byte)) * 0x100000001b3ULL;
+        }
+        return checksum;
+    }
+
+    template<typename T>
+    void Append(std::vector<char>& payload, const T* values, size_t num_values) {
+        const char* bytes = reinterpret_cast<const char*>(values);
+        payload.insert(payload.end(), bytes, bytes + num_values * sizeof(T));
+    }
+
+    template<typename T>
+    bool Extract(const std::vector<char>& payload, size_t& position, T* values, size_t num_values) {
+        if(num_values > (payload.size() - position) / sizeof(T)) {
+            return false;
+        }
+        std::memcpy(values, payload.data() + position, num_values * sizeof(T));
+        position += num_values * sizeof(T);
+        return true;
+    }
+
+    void AppendSnapshot(std::vector<char>& payload, const GraphSnapshot& snapshot) {
+        uint64_t sizes[2] = {static_cast<uint64_t>(snapshot.num_nodes), snapshot.weights.size()};
+        Append(payload, sizes, 2);
+        Append(payload, snapshot.edges.data(), snapshot.edges.size());
+        Append(payload, snapshot.weights.data(), snapshot.weights.size());
+    }
+
+    bool ExtractSnapshot(const std::vector<char>& payload, size_t& position, GraphSnapshot& snapshot) {
+        uint64_t sizes[2];
+        if(!Extract(payload, position, sizes, 2) || sizes[1] > payload.size()) {
+            return false;
+        }
+        snapshot.num_nodes = sizes[0];
+        snapshot.edges.resize(2 * sizes[1]);
+        snapshot.weights.resize(sizes[1]);
+        return Extract(payload, position, snapshot.edges.data(), snapshot.edges.size()) && Extract(payload, position, snapshot.weights.data(), snapshot.weights.size());
+    }
+
+    // iteration of a checkpoint file name, -1 for anything else in the directory
+    int GetCheckpointIteration(const std::filesystem::path& checkpoint_file) {
+        std::string file_name = checkpoint_file.filename().string();
+        if(file_name.size() <= 16 || file_name.compare(0, 11, "checkpoint.") != 0 || file_name.compare(file_name.size() - 5, 5, ".ccck") != 0) {
+            return -1;
+        }
+        std::string iteration = file_name.substr(11, file_name.size() - 16);
+        if(iteration.find_first_not_of("0123456789") != std::string::npos) {
+            return -1;
+        }
+        return std::stoi(iteration);
+    }
+}
+
+GraphSnapshot GraphSnapshot::FromGraph(igraph_t* graph_ptr) {
+    GraphSnapshot snapshot;
+    snapshot.num_nodes = igraph_vcount(graph_ptr);
+    int64_t num_edges = igraph_ecount(graph_ptr);
+    snapshot.edges.resize(2 * num_edges);
+    #pragma omp parallel for schedule(static)
+    for(int64_t current_edge = 0; current_edge < num_edges; current_edge ++) {
+        snapshot.edges[2 * current_edge] = IGRAPH_FROM(graph_ptr, current_edge);
+        snapshot.edges[2 * current_edge + 1] = IGRAPH_TO(graph_ptr, current_edge);
+    }
+    igraph_vector_t weight_vector;
+    igraph_vector_init(&weight_vector, 0);
+    igraph_cattribute_EANV(graph_ptr, "weight", igraph_ess_all(IGRAPH_EDGEORDER_ID), &weight_vector);
+    snapshot.weights.assign(VECTOR(weight_vector), VECTOR(weight_vector) + num_edges);
+    igraph_vector_destroy(&weight_vector);
+    return snapshot;
+}
+
+void GraphSnapshot::ToGraph(igraph_t* graph_ptr) const {
+    igraph_vector_int_t edge_vector;
+    igraph_vector_int_init(&edge_vector, this->edges.size());
+    #pragma omp parallel for schedule(static)
+    for(size_t i = 0; i < this->edges.size(); i ++) {
+        VECTOR(edge_vector)[i] = this->edges[i];
+    }
+    igraph_create(graph_ptr, &edge_vector, this->num_nodes, IGRAPH_UNDIRECTED);
+    igraph_vector_int_destroy(&edge_vector);
+    igraph_vector_t weight_vector;
+    igraph_vector_view(&weight_vector, this->weights.data(), this->weights.size());
+    SETEANV(graph_ptr, "weight", &weight_vector);
+}
+
+CheckpointWriter::CheckpointWriter(std::string checkpoint_directory) : checkpoint_directory(checkpoint_directory) {
+    std::filesystem::create_directories(this->checkpoint_directory);
+    this->writer_thread = std::thread(&CheckpointWriter::WriterLoop, this);
+}
+
+CheckpointWriter::~CheckpointWriter() {
+    {
+        std::lock_guard<std::mutex> pending_guard(this->pending_mutex);
+        this->stopping = true;
+    }
+    this->pending_condition.notify_one();
+    this->writer_thread.join();
+}
+
+void CheckpointWriter::Submit(std::unique_ptr<IterationState> state) {
+    {
+        std::lock_guard<std::mutex> pending_guard(this->pending_mutex);
+        this->pending_state = std::move(state);
+    }
+    this->pending_condition.notify_one();
+}
+
+void CheckpointWriter::WriterLoop() {
+    while(true) {
+        std::unique_ptr<IterationState> state;
+        {
+            std::unique_lock<std::mutex> pending_lock(this->pending_mutex);
+            this->pending_condition.wait(pending_lock, [this] { return this->pending_state || this->stopping; });
+            if(!this->pending_state) {
+                return;
+            }
+            state = std::move(this->pending_state);
+        }
+        if(!this->Write(*state)) {
+            continue;
+        }
+        // everything but this checkpoint and the one before it is superseded
+        std::error_code directory_error;
+        for(auto const& entry : std::filesystem::directory_iterator(this->checkpoint_directory, directory_error)) {
+            int iteration = GetCheckpointIteration(entry.path());
+            if(iteration != -1 && iteration < state->iteration - 1) {
+                std::error_code remove_error;
+                std::filesystem::remove(entry.path(), remove_error);
+            }
+        }
+    }
+}
+
+std::string CheckpointWriter::GetCheckpointFile(int iteration) const {
+    return (std::filesystem::path(this->checkpoint_directory) / ("checkpoint." + std::to_string(iteration) + ".ccck")).string();
+}
+
+bool CheckpointWriter::Write(const IterationState& state) {
+    std::vector<char> payload;
+    AppendSnapshot(payload, state.graph);
+    AppendSnapshot(payload, state.next_graph);
+    CheckpointHeader header = {{'C', 'C', 'C', 'K'}, CheckpointWriter::version, state.configuration_hash, static_cast<uint64_t>(state.iteration), payload.size(), Checksum(payload)};
+
+    std::string checkpoint_file = this->GetCheckpointFile(state.iteration);
+    std::string temporary_file = checkpoint_file + ".tmp";
+    FILE* checkpoint_file_handle = fopen(temporary_file.c_str(), "wb");
+    if(checkpoint_file_handle == NULL) {
+        return false;
+    }
+    bool success = fwrite(&header, sizeof(header), 1, checkpoint_file_handle) == 1;
+    success = success && fwrite(payload.data(), 1, payload.size(), checkpoint_file_handle) == payload.size();
+    success = success && fflush(checkpoint_file_handle) == 0 && fsync(fileno(checkpoint_file_handle)) == 0;
+    success = (fclose(checkpoint_file_handle) == 0) && success;
+    std::error_code rename_error;
+    if(success) {
+        std::filesystem::rename(temporary_file, checkpoint_file, rename_error);
+    }
+    if(!success || rename_error) {
+        std::error_code remove_error;
+        std::filesystem::remove(temporary_file, remove_error);
+        return false;
+    }
+    return true;
+}
+
+bool CheckpointWriter::ReadLatest(std::string checkpoint_directory, uint64_t configuration_hash, IterationState& state) {
+    std::vector<int> iterations;
+    std::error_code directory_error;
+    for(auto const& entry : std::filesystem::directory_iterator(checkpoint_directory, directory_error)) {
+        int iteration = GetCheckpointIteration(entry.path());
+        if(iteration != -1) {
+            iterations.push_back(iteration);
+        }
+    }
+    std::sort(iterations.rbegin(), iterations.rend());
+    // a checkpoint that is truncated, corrupted or from another run falls back to the one before it
+    for(int iteration : iterations) {
+        std::string checkpoint_file = (std::filesystem::path(checkpoint_directory) / ("checkpoint." + std::to_string(iteration) + ".ccck")).string();
+        FILE* checkpoint_file_handle = fopen(checkpoint_file.c_str(), "rb");
+        if(checkpoint_file_handle == NULL) {
+            continue;
+        }
+        std::error_code size_error;
+        uint64_t file_size = std::filesystem::file_size(checkpoint_file, size_error);
+        CheckpointHeader header;
+        std::vector<char> payload;
+        bool success = !size_error && fread(&header, sizeof(header), 1, checkpoint_file_handle) == 1
+            && std::memcmp(header.magic, "CCCK", 4) == 0
+            && header.version == CheckpointWriter::version
+            && header.configuration_hash == configuration_hash
+            && header.iteration == static_cast<uint64_t>(iteration)
+            && header.payload_size == file_size - sizeof(header);
+        if(success) {
+            payload.resize(header.payload_size);
+            success = fread(payload.data(), 1, payload.size(), checkpoint_file_handle) == payload.size() && Checksum(payload) == header.checksum;
+        }
+        fclose(checkpoint_file_handle);
+        size_t position = 0;
+        if(success && ExtractSnapshot(payload, position, state.graph) && ExtractSnapshot(payload, position, state.next_graph)) {
+            state.configuration_hash = configuration_hash;
+            state.iteration = iteration;
+            return true;
+        }
+    }
+    return false;
+}
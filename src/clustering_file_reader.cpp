@@ -0,0 +1,226 @@
+#include "clustering_file_reader.h"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    struct MappedFile {
+        const char* data = nullptr;
+        size_t size = 0;
+    };
+
+    MappedFile MapFile(const std::string& file_name) {
+        MappedFile mapped_file;
+        int file_descriptor = open(file_name.c_str(), O_RDONLY);
+        if(file_descriptor == -1) {
+            return mapped_file;
+        }
+        struct stat file_stat;
+        if(fstat(file_descriptor, &file_stat) == 0 && file_stat.st_size > 0) {
+            void* data = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+            if(data != MAP_FAILED) {
+                madvise(data, file_stat.st_size, MADV_SEQUENTIAL);
+                mapped_file.data = static_cast<const char*>(data);
+                mapped_file.size = file_stat.st_size;
+            }
+        }
+        close(file_descriptor);
+        return mapped_file;
+    }
+
+    inline bool IsSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+    }
+
+    inline bool IsLineSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    }
+}
+
+void ClusteringFileReader::ParseChunk(Chunk& chunk) {
+    const char* current = chunk.begin;
+    while(current < chunk.end) {
+        while(current < chunk.end && IsSpace(*current)) {
+            current ++;
+        }
+        const char* node_begin = current;
+        while(current < chunk.end && !IsSpace(*current)) {
+            current ++;
+        }
+        std::string_view node_name(node_begin, current - node_begin);
+        while(current < chunk.end && IsLineSpace(*current)) {
+            current ++;
+        }
+        const char* cluster_begin = current;
+        while(current < chunk.end && !IsSpace(*current)) {
+            current ++;
+        }
+        std::string_view cluster_name(cluster_begin, current - cluster_begin);
+        while(current < chunk.end && *current != '\n') {
+            current ++;
+        }
+        if(node_name.empty() || cluster_name.empty()) {
+            continue;
+        }
+
+        auto [cluster_it, inserted] = chunk.cluster_name_to_label_map.try_emplace(cluster_name, chunk.cluster_names.size());
+        if(inserted) {
+            chunk.cluster_names.push_back(cluster_name);
+        }
+        auto node_it = this->node_name_to_id_map->find(node_name);
+        int node_id = node_it == this->node_name_to_id_map->end() ? -1 : node_it->second;
+        chunk.entries.emplace_back(node_id, cluster_it->second);
+    }
+}
+
+bool ClusteringFileReader::ReadBinaryFile(const std::string& clustering_file, std::vector<int>& labels, std::vector<std::atomic<int>>& cluster_sizes) {
+    std::vector<uint32_t> binary_labels;
+    uint64_t id_map;
+    if(!MembershipIO::ReadBinaryMembership(clustering_file, binary_labels, &id_map)) {
+        return false;
+    }
+    bool same_id_map = id_map == this->id_map && binary_labels.size() == labels.size();
+    if(!same_id_map && id_map != MembershipIO::identity_id_map) {
+        // written against a different graph, the labels cannot be matched to our vertices
+        return false;
+    }
+    uint32_t max_label = 0;
+    for(uint32_t label : binary_labels) {
+        if(label != MembershipIO::no_membership) {
+            max_label = std::max(max_label, label);
+        }
+    }
+    cluster_sizes = std::vector<std::atomic<int>>(static_cast<size_t>(max_label) + 1);
+    for(size_t i = 0; i < binary_labels.size(); i ++) {
+        uint32_t label = binary_labels[i];
+        if(label == MembershipIO::no_membership) {
+            continue;
+        }
+        cluster_sizes[label].fetch_add(1, std::memory_order_relaxed);
+        if(same_id_map) {
+            labels[i] = label;
+        } else {
+            // label i belongs to the node named i
+            char node_name_buffer[24];
+            auto [node_name_end, node_name_error] = std::to_chars(node_name_buffer, node_name_buffer + sizeof(node_name_buffer), i);
+            auto node_it = this->node_name_to_id_map->find(std::string_view(node_name_buffer, node_name_end - node_name_buffer));
+            if(node_it != this->node_name_to_id_map->end()) {
+                labels[node_it->second] = label;
+            }
+        }
+    }
+    return true;
+}
+
+std::vector<std::vector<int>> ClusteringFileReader::Read(const std::vector<std::string>& clustering_files) {
+    int num_files = clustering_files.size();
+    std::vector<MappedFile> mapped_files(num_files);
+    std::vector<char> is_binary(num_files);
+    #pragma omp parallel for schedule(dynamic) num_threads(this->num_threads)
+    for(int i = 0; i < num_files; i ++) {
+        is_binary[i] = MembershipIO::IsBinaryMembershipFile(clustering_files[i]);
+        if(!is_binary[i]) {
+            mapped_files[i] = MapFile(clustering_files[i]);
+        }
+    }
+
+    // every file gets enough chunks for all threads to stay busy when there are only a few files
+    int chunks_per_file = std::max(1, (this->num_threads + num_files - 1) / std::max(1, num_files)) * 4;
+    std::vector<Chunk> chunks;
+    std::vector<size_t> first_chunk(num_files + 1);
+    for(int i = 0; i < num_files; i ++) {
+        first_chunk[i] = chunks.size();
+        const char* file_begin = mapped_files[i].data;
+        const char* file_end = file_begin + mapped_files[i].size;
+        size_t chunk_size = std::max<size_t>(1 << 16, mapped_files[i].size / chunks_per_file + 1);
+        const char* chunk_begin = file_begin;
+        while(chunk_begin < file_end) {
+            const char* chunk_end = chunk_begin + std::min<size_t>(chunk_size, file_end - chunk_begin);
+            while(chunk_end < file_end && *(chunk_end - 1) != '\n') {
+                chunk_end ++;
+            }
+            chunks.push_back({i, chunk_begin, chunk_end, {}, {}, {}, {}});
+            chunk_begin = chunk_end;
+        }
+    }
+    first_chunk[num_files] = chunks.size();
+
+    #pragma omp parallel for schedule(dynamic) num_threads(this->num_threads)
+    for(size_t i = 0; i < chunks.size(); i ++) {
+        this->ParseChunk(chunks[i]);
+    }
+
+    // cluster names are numbered per file in order of first appearance so labels do not depend on the chunking
+    std::vector<std::vector<std::atomic<int>>> cluster_sizes(num_files);
+    #pragma omp parallel for schedule(dynamic) num_threads(this->num_threads)
+    for(int i = 0; i < num_files; i ++) {
+        std::unordered_map<std::string_view, int> cluster_name_to_label_map;
+        for(size_t chunk_index = first_chunk[i]; chunk_index < first_chunk[i + 1]; chunk_index ++) {
+            Chunk& chunk = chunks[chunk_index];
+            chunk.local_to_file_label.resize(chunk.cluster_names.size());
+            for(size_t local_label = 0; local_label < chunk.cluster_names.size(); local_label ++) {
+                auto [cluster_it, inserted] = cluster_name_to_label_map.try_emplace(chunk.cluster_names[local_label], cluster_name_to_label_map.size());
+                chunk.local_to_file_label[local_label] = cluster_it->second;
+            }
+            chunk.cluster_name_to_label_map.clear();
+            chunk.cluster_names.clear();
+        }
+        cluster_sizes[i] = std::vector<std::atomic<int>>(cluster_name_to_label_map.size());
+    }
+
+    int num_nodes = this->node_name_to_id_map->size();
+    std::vector<std::vector<int>> clusterings(num_files, std::vector<int>(num_nodes, -1));
+    #pragma omp parallel for schedule(dynamic) num_threads(this->num_threads)
+    for(size_t i = 0; i < chunks.size(); i ++) {
+        Chunk& chunk = chunks[i];
+        std::vector<int>& labels = clusterings[chunk.file_index];
+        std::vector<std::atomic<int>>& current_cluster_sizes = cluster_sizes[chunk.file_index];
+        for(auto const& [node_id, local_label] : chunk.entries) {
+            int label = chunk.local_to_file_label[local_label];
+            current_cluster_sizes[label].fetch_add(1, std::memory_order_relaxed);
+            if(node_id != -1) {
+                labels[node_id] = label;
+            }
+        }
+        chunk.entries.clear();
+        chunk.entries.shrink_to_fit();
+    }
+
+    std::vector<char> read_failed(num_files, false);
+    #pragma omp parallel for schedule(dynamic) num_threads(this->num_threads)
+    for(int i = 0; i < num_files; i ++) {
+        if(is_binary[i]) {
+            read_failed[i] = !this->ReadBinaryFile(clustering_files[i], clusterings[i], cluster_sizes[i]);
+        }
+    }
+
+    for(int i = 0; i < num_files; i ++) {
+        std::vector<int>& labels = clusterings[i];
+        std::vector<std::atomic<int>>& current_cluster_sizes = cluster_sizes[i];
+        #pragma omp parallel for schedule(static) num_threads(this->num_threads)
+        for(int node_id = 0; node_id < num_nodes; node_id ++) {
+            if(labels[node_id] != -1 && current_cluster_sizes[labels[node_id]].load(std::memory_order_relaxed) < 2) {
+                labels[node_id] = -1;
+            }
+        }
+    }
+
+    for(int i = 0; i < num_files; i ++) {
+        if(mapped_files[i].data != nullptr) {
+            munmap(const_cast<char*>(mapped_files[i].data), mapped_files[i].size);
+        }
+    }
+    // a clustering that could not be read would otherwise count as every node being unclustered
+    for(int i = 0; i < num_files; i ++) {
+        if(read_failed[i]) {
+            throw std::runtime_error("could not read the binary membership file " + clustering_files[i] + ", it is corrupt or was written for another graph");
+        }
+    }
+    return clusterings;
+}
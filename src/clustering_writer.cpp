@@ -0,0 +1,104 @@
+#include "clustering_writer.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+    bool WriteAll(int file_descriptor, const char* data, size_t size) {
+        while(size > 0) {
+            ssize_t written = write(file_descriptor, data, size);
+            if(written < 0) {
+                return false;
+            }
+            data += written;
+            size -= written;
+        }
+        return true;
+    }
+}
+
+bool ClusteringWriter::WriteText(std::string output_file, const std::vector<uint32_t>& labels, const std::vector<const char*>* node_names) {
+    int file_descriptor = open(output_file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(file_descriptor == -1) {
+        return false;
+    }
+    int64_t num_nodes = labels.size();
+    int64_t num_blocks = (num_nodes + ClusteringWriter::block_size - 1) / ClusteringWriter::block_size;
+    bool success = true;
+    #pragma omp parallel reduction(&&: success)
+    {
+        std::vector<char> buffer;
+        #pragma omp for ordered schedule(static, 1)
+        for(int64_t block = 0; block < num_blocks; block ++) {
+            buffer.clear();
+            int64_t block_end = std::min<int64_t>(num_nodes, (block + 1) * ClusteringWriter::block_size);
+            for(int64_t node_id = block * ClusteringWriter::block_size; node_id < block_end; node_id ++) {
+                if(labels[node_id] == MembershipIO::no_membership) {
+                    continue;
+                }
+                // longest line is a node name or a 20 digit id, a space, a 10 digit label and a newline
+                size_t node_name_length = node_names != nullptr ? std::strlen((*node_names)[node_id]) : 20;
+                size_t position = buffer.size();
+                buffer.resize(position + node_name_length + 13);
+                char* current = buffer.data() + position;
+                char* line_end = buffer.data() + buffer.size();
+                if(node_names != nullptr) {
+                    std::memcpy(current, (*node_names)[node_id], node_name_length);
+                    current += node_name_length;
+                } else {
+                    current = std::to_chars(current, line_end, node_id).ptr;
+                }
+                *current ++ = ' ';
+                current = std::to_chars(current, line_end, labels[node_id]).ptr;
+                *current ++ = '\n';
+                buffer.resize(current - buffer.data());
+            }
+            #pragma omp ordered
+            {
+                success = WriteAll(file_descriptor, buffer.data(), buffer.size()) && success;
+            }
+        }
+    }
+    success = (close(file_descriptor) == 0) && success;
+    return success;
+}
+
+void ClusteringWriter::RelabelBySize(std::vector<uint32_t>& labels) {
+    uint32_t num_clusters = 0;
+    #pragma omp parallel for reduction(max: num_clusters)
+    for(size_t node_id = 0; node_id < labels.size(); node_id ++) {
+        if(labels[node_id] != MembershipIO::no_membership) {
+            num_clusters = std::max(num_clusters, labels[node_id] + 1);
+        }
+    }
+    std::vector<uint32_t> cluster_sizes(num_clusters, 0);
+    #pragma omp parallel for
+    for(size_t node_id = 0; node_id < labels.size(); node_id ++) {
+        if(labels[node_id] != MembershipIO::no_membership) {
+            #pragma omp atomic
+            cluster_sizes[labels[node_id]] ++;
+        }
+    }
+    std::vector<uint32_t> cluster_order;
+    for(uint32_t cluster_id = 0; cluster_id < num_clusters; cluster_id ++) {
+        if(cluster_sizes[cluster_id] > 0) {
+            cluster_order.push_back(cluster_id);
+        }
+    }
+    std::stable_sort(cluster_order.begin(), cluster_order.end(), [&cluster_sizes](uint32_t a, uint32_t b) {
+        return cluster_sizes[a] > cluster_sizes[b];
+    });
+    std::vector<uint32_t> new_cluster_id(num_clusters);
+    for(size_t i = 0; i < cluster_order.size(); i ++) {
+        new_cluster_id[cluster_order[i]] = i;
+    }
+    #pragma omp parallel for
+    for(size_t node_id = 0; node_id < labels.size(); node_id ++) {
+        if(labels[node_id] != MembershipIO::no_membership) {
+            labels[node_id] = new_cluster_id[labels[node_id]];
+        }
+    }
+}
@@ -0,0 +1,165 @@
+#include "connectivity_modifier.h"
+
+std::map<int, int> ConnectivityModifier::Run(const std::map<int, int>& partition_map) {
+    std::map<int, std::vector<int>> cluster_to_nodes_map;
+    for(auto const& [node_id, cluster_id] : partition_map) {
+        cluster_to_nodes_map[cluster_id].push_back(node_id);
+    }
+
+    #pragma omp parallel
+    {
+        #pragma omp single
+        {
+            for(auto const& [cluster_id, members] : cluster_to_nodes_map) {
+                std::vector<int> cluster_members = members;
+                #pragma omp task firstprivate(cluster_members)
+                this->ProcessCluster(cluster_members);
+            }
+        }
+    }
+
+    // tasks finish in any order so order the clusters by their smallest node before numbering them
+    std::sort(this->final_clusters.begin(), this->final_clusters.end());
+    std::map<int, int> cm_partition_map;
+    int current_cluster_id = 0;
+    for(auto const& members : this->final_clusters) {
+        for(int node_id : members) {
+            cm_partition_map[node_id] = current_cluster_id;
+        }
+        current_cluster_id ++;
+    }
+    // nodes that CM dropped still need a cluster so the callers can look every edge endpoint up
+    for(auto const& [node_id, cluster_id] : partition_map) {
+        if(!cm_partition_map.contains(node_id)) {
+            cm_partition_map[node_id] = current_cluster_id ++;
+        }
+    }
+    this->final_clusters.clear();
+    return cm_partition_map;
+}
+
+void ConnectivityModifier::ProcessCluster(const std::vector<int>& members) {
+    if(members.size() < 2) {
+        return;
+    }
+    igraph_t subgraph;
+    this->BuildSubgraph(members, &subgraph);
+
+    std::vector<std::vector<int>> sides;
+    igraph_vector_int_t component_id_vector;
+    igraph_vector_int_init(&component_id_vector, 0);
+    igraph_integer_t number_of_components;
+    igraph_connected_components(&subgraph, &component_id_vector, NULL, &number_of_components, IGRAPH_WEAK);
+    if(number_of_components > 1) {
+        // a disconnected cluster has a cut of zero and is split along its components
+        sides.resize(number_of_components);
+        for(size_t i = 0; i < members.size(); i ++) {
+            sides[VECTOR(component_id_vector)[i]].push_back(members[i]);
+        }
+    } else {
+        igraph_real_t mincut_value;
+        igraph_vector_int_t partition;
+        igraph_vector_int_t partition2;
+        igraph_vector_int_init(&partition, 0);
+        igraph_vector_int_init(&partition2, 0);
+        igraph_mincut(&subgraph, &mincut_value, &partition, &partition2, NULL, NULL);
+        if(ConnectivityModifier::IsWellConnected(mincut_value, members.size())) {
+            std::lock_guard<std::mutex> final_clusters_guard(this->final_clusters_mutex);
+            this->final_clusters.push_back(members);
+        } else {
+            sides.resize(2);
+            for(igraph_integer_t i = 0; i < igraph_vector_int_size(&partition); i ++) {
+                sides[0].push_back(members[VECTOR(partition)[i]]);
+            }
+            for(igraph_integer_t i = 0; i < igraph_vector_int_size(&partition2); i ++) {
+                sides[1].push_back(members[VECTOR(partition2)[i]]);
+            }
+        }
+        igraph_vector_int_destroy(&partition);
+        igraph_vector_int_destroy(&partition2);
+    }
+    igraph_vector_int_destroy(&component_id_vector);
+    igraph_destroy(&subgraph);
+
+    for(auto& side : sides) {
+        std::sort(side.begin(), side.end());
+        this->ReclusterSide(side);
+    }
+}
+
+void ConnectivityModifier::ReclusterSide(const std::vector<int>& side) {
+    if(side.size() < 2) {
+        return;
+    }
+    igraph_t side_graph;
+    this->BuildSubgraph(side, &side_graph);
+    // the clustering algorithms seed and draw from igraph's process wide default rng, so concurrent tasks
+    // would interleave their draws and make the result depend on the schedule
+    std::map<int, int> side_partition_map;
+    #pragma omp critical(connectivity_modifier_recluster)
+    side_partition_map = this->recluster(&side_graph);
+    igraph_destroy(&side_graph);
+
+    std::map<int, std::vector<int>> cluster_to_nodes_map;
+    for(auto const& [local_node_id, cluster_id] : side_partition_map) {
+        cluster_to_nodes_map[cluster_id].push_back(side[local_node_id]);
+    }
+    for(auto const& [cluster_id, members] : cluster_to_nodes_map) {
+        if(members.size() > 1) {
+            std::vector<int> cluster_members = members;
+            #pragma omp task firstprivate(cluster_members)
+            this->ProcessCluster(cluster_members);
+        }
+    }
+}
+
+void ConnectivityModifier::BuildSubgraph(const std::vector<int>& members, igraph_t* subgraph_ptr) {
+    // members are sorted so local ids are found by binary search instead of a copy of the graph
+    igraph_vector_int_t edge_vector;
+    igraph_vector_int_init(&edge_vector, 0);
+    igraph_vector_int_t incident_vector;
+    igraph_vector_int_init(&incident_vector, 0);
+    std::vector<igraph_integer_t> edge_ids;
+    for(size_t local_node_id = 0; local_node_id < members.size(); local_node_id ++) {
+        igraph_incident(this->graph_ptr, &incident_vector, members[local_node_id], IGRAPH_ALL);
+        for(igraph_integer_t i = 0; i < igraph_vector_int_size(&incident_vector); i ++) {
+            igraph_integer_t current_edge = VECTOR(incident_vector)[i];
+            int neighbor = IGRAPH_FROM(this->graph_ptr, current_edge);
+            if(neighbor == members[local_node_id]) {
+                neighbor = IGRAPH_TO(this->graph_ptr, current_edge);
+            }
+            auto position = std::lower_bound(members.begin(), members.end(), neighbor);
+            if(position != members.end() && *position == neighbor) {
+                int local_neighbor_id = position - members.begin();
+                if(static_cast<int>(local_node_id) < local_neighbor_id) {
+                    igraph_vector_int_push_back(&edge_vector, local_node_id);
+                    igraph_vector_int_push_back(&edge_vector, local_neighbor_id);
+                    edge_ids.push_back(current_edge);
+                }
+            }
+        }
+    }
+    igraph_create(subgraph_ptr, &edge_vector, members.size(), IGRAPH_UNDIRECTED);
+    igraph_vector_int_destroy(&incident_vector);
+    igraph_vector_int_destroy(&edge_vector);
+
+    // the reclustering sees the same weights, and on a coarse graph the same multiplicities and supernode sizes
+    igraph_vector_t attribute_vector;
+    igraph_vector_init(&attribute_vector, edge_ids.size());
+    for(const char* attribute_name : {"weight", "coarse_weight"}) {
+        if(igraph_cattribute_has_attr(this->graph_ptr, IGRAPH_ATTRIBUTE_EDGE, attribute_name)) {
+            for(size_t i = 0; i < edge_ids.size(); i ++) {
+                VECTOR(attribute_vector)[i] = EAN(this->graph_ptr, attribute_name, edge_ids[i]);
+            }
+            SETEANV(subgraph_ptr, attribute_name, &attribute_vector);
+        }
+    }
+    if(igraph_cattribute_has_attr(this->graph_ptr, IGRAPH_ATTRIBUTE_VERTEX, "coarse_size")) {
+        igraph_vector_resize(&attribute_vector, members.size());
+        for(size_t local_node_id = 0; local_node_id < members.size(); local_node_id ++) {
+            VECTOR(attribute_vector)[local_node_id] = VAN(this->graph_ptr, "coarse_size", members[local_node_id]);
+        }
+        SETVANV(subgraph_ptr, "coarse_size", &attribute_vector);
+    }
+    igraph_vector_destroy(&attribute_vector);
+}
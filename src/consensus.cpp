@@ -1,35 +1,279 @@
 #include "consensus.h"
 
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
 /*
  * message type here is 1 for INFO, 2 for DEBUG, and -1 for ERROR
  */
 
 void Consensus::LoadIgraphFromFile(igraph_t* graph_ptr) {
+    bool simplify = true;
+    this->ReadEdgelist(graph_ptr, simplify);
+    this->PreprocessGraph(graph_ptr);
+}
+
+bool Consensus::AttachSharedGraph(bool simplify) {
+    if(this->shared_graph_name.empty()) {
+        return false;
+    }
+    this->shared_graph = SharedGraphSegment::Attach(this->shared_graph_name, SharedGraphSegment::GetSourceKey(this->edgelist, simplify));
+    if(this->shared_graph) {
+        this->WriteToLogFile("Attached to the shared graph " + this->shared_graph_name, 1);
+    }
+    return this->shared_graph != nullptr;
+}
+
+void Consensus::ReadEdgelist(igraph_t* graph_ptr, bool simplify) {
+    PhaseMetrics::Phase load_phase("load");
+    if(this->AttachSharedGraph(simplify)) {
+        this->shared_graph->ToGraph(graph_ptr);
+        load_phase.edges_processed = igraph_ecount(graph_ptr);
+        return;
+    }
     FILE* edgelist_file = fopen(this->edgelist.c_str(), "r");
     igraph_read_graph_edgelist(graph_ptr, edgelist_file, 0, false);
     fclose(edgelist_file);
-    bool remove_parallel_edges = true;
-    bool remove_self_loops = true;
-    igraph_simplify(graph_ptr, remove_parallel_edges, remove_self_loops, NULL);
+    if(simplify) {
+        bool remove_parallel_edges = true;
+        bool remove_self_loops = true;
+        igraph_simplify(graph_ptr, remove_parallel_edges, remove_self_loops, NULL);
+    }
+    if(igraph_vcount(graph_ptr) > std::numeric_limits<int32_t>::max()) {
+        // edges are indexed with 64 bits when needed but node ids stay 32-bit in the partition maps and membership files
+        this->WriteToLogFile("The edge-list has " + std::to_string(igraph_vcount(graph_ptr)) + " nodes, more than the 2^31 - 1 node ids the partitions can hold", -1);
+        throw std::overflow_error("too many nodes in " + this->edgelist);
+    }
+    load_phase.edges_processed = igraph_ecount(graph_ptr);
+    if(!this->shared_graph_name.empty()) {
+        this->shared_graph = SharedGraphSegment::Publish(this->shared_graph_name, SharedGraphSegment::GetSourceKey(this->edgelist, simplify), graph_ptr);
+        if(this->shared_graph) {
+            this->WriteToLogFile("Published the graph as the shared graph " + this->shared_graph_name, 1);
+        } else {
+            this->WriteToLogFile("Could not publish the shared graph " + this->shared_graph_name + ", it may belong to another edge-list", 1);
+        }
+    }
+}
+
+void Consensus::PreprocessGraph(igraph_t* graph_ptr) {
+    if(this->prune_mode != "none") {
+        this->WriteToLogFile("Started pruning the graph", 1);
+        this->pruning = std::make_unique<GraphPruning>(graph_ptr, this->prune_mode == "paths");
+        this->WriteToLogFile("Finished pruning " + std::to_string(this->pruning->num_tree_nodes) + " tree nodes and " + std::to_string(this->pruning->num_path_nodes) + " path nodes", 1);
+    }
+    // pruning keeps the input ids, so the graph is reordered last and restored first
+    if(this->reorder_mode != "none") {
+        this->WriteToLogFile("Started reordering the graph (" + this->reorder_mode + ")", 1);
+        this->reordering = std::make_unique<GraphReordering>(graph_ptr, this->reorder_mode);
+        this->WriteToLogFile("Finished reordering the graph", 1);
+    }
 }
 
-void Consensus::StartWorkers(igraph_t* graph_ptr) {
+bool Consensus::ResumeFromCheckpoint(igraph_t* graph_ptr, igraph_t* next_graph_ptr, int& iter_count) {
+    if(this->checkpoint_directory.empty()) {
+        return false;
+    }
+    // checkpoints only apply to the same preprocessed graph and the same partition file
+    const uint64_t fnv_prime = 0x100000001b3ULL;
+    this->configuration_hash = PartitionCache::HashGraph(graph_ptr);
     for(int i = 0; i < this->num_partitions; i ++) {
-        Consensus::num_partition_index_queue.push(i);
+        for(char c : this->algorithm_vector[i]) {
+            this->configuration_hash = (this->configuration_hash ^ static_cast<uint8_t>(c)) * fnv_prime;
+        }
+        this->configuration_hash = (this->configuration_hash ^ std::hash<double>{}(this->clustering_parameter_vector[i])) * fnv_prime;
+        this->configuration_hash = (this->configuration_hash ^ std::hash<double>{}(this->weight_vector[i])) * fnv_prime;
     }
-    for(int i = 0; i < this->num_processors; i ++) {
-        Consensus::num_partition_index_queue.push(-1);
+    this->configuration_hash = (this->configuration_hash ^ std::hash<double>{}(this->threshold)) * fnv_prime;
+    // voting and the convergence test change which graph an iteration produces
+    this->configuration_hash = (this->configuration_hash ^ static_cast<uint64_t>(Consensus::voting_flag)) * fnv_prime;
+    for(double setting : this->GetConvergenceSettings()) {
+        this->configuration_hash = (this->configuration_hash ^ std::hash<double>{}(setting)) * fnv_prime;
+    }
+    this->checkpoint_writer = std::make_unique<CheckpointWriter>(this->checkpoint_directory);
+    if(!this->resume_flag) {
+        return false;
     }
 
-    std::vector<std::thread> thread_vector;
-    for(int i = 0; i < this->num_processors; i ++) {
-        thread_vector.push_back(std::thread(Consensus::ClusterWorker, this->edgelist, std::ref(this->algorithm_vector), std::ref(this->clustering_parameter_vector), graph_ptr));
+    this->WriteToLogFile("Started looking for a checkpoint in " + this->checkpoint_directory, 1);
+    IterationState state;
+    if(!CheckpointWriter::ReadLatest(this->checkpoint_directory, this->configuration_hash, state)) {
+        this->WriteToLogFile("Found no valid checkpoint, starting from the first iteration", 1);
+        return false;
     }
+    igraph_destroy(graph_ptr);
+    state.graph.ToGraph(graph_ptr);
+    state.next_graph.ToGraph(next_graph_ptr);
+    iter_count = state.iteration;
+    this->WriteToLogFile("Finished resuming after iteration " + std::to_string(iter_count), 1);
+    return true;
+}
 
-    for(int i = 0; i < this->num_processors; i ++) {
-        thread_vector[i].join();
+void Consensus::CheckpointIteration(igraph_t* graph_ptr, igraph_t* next_graph_ptr, int iter_count) {
+    if(!this->checkpoint_writer) {
+        return;
     }
+    // only the copy happens here, the file is written while the next iteration runs
+    std::unique_ptr<IterationState> state = std::make_unique<IterationState>();
+    state->configuration_hash = this->configuration_hash;
+    state->iteration = iter_count;
+    state->graph = GraphSnapshot::FromGraph(graph_ptr);
+    state->next_graph = GraphSnapshot::FromGraph(next_graph_ptr);
+    this->checkpoint_writer->Submit(std::move(state));
 }
+
+void Consensus::StartWorkers(igraph_t* graph_ptr, int first_partition, int last_partition) {
+    // the default range is every row of the partition file, generate clusters a slice of it
+    if(last_partition == -1) {
+        last_partition = this->num_partitions - 1;
+    }
+    int num_range_partitions = last_partition - first_partition + 1;
+    std::unique_ptr<PartitionCache> partition_cache;
+    if(!this->cache_directory.empty() && graph_ptr != nullptr) {
+        partition_cache = std::make_unique<PartitionCache>(this->cache_directory, graph_ptr);
+    }
+    if(this->worker_backend == "processes" && graph_ptr != nullptr) {
+        this->StartProcessWorkers(graph_ptr, first_partition, last_partition, partition_cache.get());
+    } else {
+        for(int i = first_partition; i <= last_partition; i ++) {
+            Consensus::num_partition_index_queue.push(i);
+        }
+        int num_workers = this->GetNumWorkers();
+        for(int i = 0; i < num_workers; i ++) {
+            Consensus::num_partition_index_queue.push(-1);
+        }
+
+        int num_threads_per_worker = std::max(1, this->num_processors / std::max(1, std::min(num_workers, num_range_partitions)));
+        std::vector<std::thread> thread_vector;
+        for(int i = 0; i < num_workers; i ++) {
+            thread_vector.push_back(std::thread(Consensus::ClusterWorker, this->edgelist, std::ref(this->algorithm_vector), std::ref(this->clustering_parameter_vector), graph_ptr, num_threads_per_worker, partition_cache.get()));
+        }
+
+        for(int i = 0; i < num_workers; i ++) {
+            thread_vector[i].join();
+        }
+    }
+    if(partition_cache) {
+        this->WriteToLogFile("Reused " + std::to_string(partition_cache->num_hits) + " of " + std::to_string(num_range_partitions) + " partitions from the cache", 1);
+    }
+}
+
+void Consensus::StartProcessWorkers(igraph_t* graph_ptr, int first_partition, int last_partition, PartitionCache* partition_cache) {
+    // the children share the loaded graph copy-on-write and only send their memberships back
+    int num_range_partitions = last_partition - first_partition + 1;
+    int num_workers = std::max(1, std::min(this->GetNumWorkers(), num_range_partitions));
+    MembershipRingBuffer ring_buffer(2 * num_workers, igraph_vcount(graph_ptr), first_partition);
+    std::flush(this->log_file_handle);
+    std::vector<pid_t> worker_pids;
+    for(int i = 0; i < num_workers; i ++) {
+        pid_t pid = fork();
+        if(pid == -1) {
+            this->WriteToLogFile("Could not fork worker process " + std::to_string(i), -1);
+            break;
+        }
+        if(pid == 0) {
+            // the OpenMP thread pool of the parent does not survive fork, so every process clusters on one thread
+            omp_set_num_threads(1);
+            MemoryPlacement::UnpinThisThread();
+            for(int partition_index = ring_buffer.ClaimPartition(); partition_index <= last_partition; partition_index = ring_buffer.ClaimPartition()) {
+                ScratchArena::Scope partition_scope;
+                std::map<int, int> clustering = Consensus::ComputePartition(this->edgelist, this->algorithm_vector, this->clustering_parameter_vector, partition_index, graph_ptr, partition_cache);
+                ring_buffer.Push(partition_index, clustering);
+            }
+            if(partition_cache != nullptr) {
+                ring_buffer.AddCacheHits(partition_cache->num_hits);
+            }
+            _exit(0);
+        }
+        worker_pids.push_back(pid);
+    }
+
+    int num_received = 0;
+    int num_running = worker_pids.size();
+    int64_t worker_peak_bytes = 0;
+    int partition_index;
+    std::vector<uint32_t> labels;
+    while(num_received < num_range_partitions) {
+        if(ring_buffer.TryPop(partition_index, labels)) {
+            std::map<int, int> clustering;
+            if(Consensus::partition_sink) {
+                Consensus::partition_sink(partition_index, labels);
+            } else {
+                clustering = MembershipIO::LabelsToPartitionMap(labels);
+            }
+            std::map<int, std::vector<int>> cluster_to_nodes_map;
+            if(Consensus::voting_flag && Consensus::voting_maps_flag) cluster_to_nodes_map = Consensus::GetClusterToNodeMap(clustering);
+            Consensus::done_being_clustered_clusterings.push(clustering);
+            Consensus::done_being_clustered_indices.push(partition_index);
+            if(Consensus::voting_flag && Consensus::voting_maps_flag) Consensus::done_being_clustered_cluster_to_nodes_map.push(cluster_to_nodes_map);
+            num_received ++;
+            continue;
+        }
+        if(num_running == 0) {
+            throw std::runtime_error("worker processes exited after sending " + std::to_string(num_received) + " of " + std::to_string(num_range_partitions) + " partitions");
+        }
+        int status;
+        struct rusage worker_usage;
+        pid_t exited_pid = wait4(-1, &status, WNOHANG, &worker_usage);
+        if(exited_pid > 0) {
+            num_running --;
+            worker_peak_bytes += worker_usage.ru_maxrss * int64_t(1024);
+            worker_pids.erase(std::remove(worker_pids.begin(), worker_pids.end(), exited_pid), worker_pids.end());
+            if(!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                // its claimed partition is lost and the ring position it may have reserved is never filled,
+                // so the other workers would end up waiting on that slot and the parent on the partition
+                this->WriteToLogFile("Worker process " + std::to_string(exited_pid) + " failed, stopping the other workers", -1);
+                for(pid_t worker_pid : worker_pids) {
+                    kill(worker_pid, SIGKILL);
+                }
+                while(num_running > 0 && waitpid(-1, NULL, 0) > 0) {
+                    num_running --;
+                }
+                throw std::runtime_error("worker process " + std::to_string(exited_pid) + " failed after " + std::to_string(num_received) + " of " + std::to_string(num_range_partitions) + " partitions were sent");
+            }
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    }
+    struct rusage worker_usage;
+    while(num_running > 0 && wait4(-1, NULL, 0, &worker_usage) > 0) {
+        num_running --;
+        worker_peak_bytes += worker_usage.ru_maxrss * int64_t(1024);
+    }
+    MemoryPlanner::RecordWorkerPeakBytes(worker_peak_bytes);
+    if(partition_cache != nullptr) {
+        partition_cache->num_hits += ring_buffer.NumCacheHits();
+    }
+}
+
+void Consensus::PlanMemory(igraph_t* graph_ptr, bool iterative, bool streaming_possible) {
+    if(this->max_memory == 0) {
+        return;
+    }
+    MemoryPlanner memory_planner(igraph_vcount(graph_ptr), igraph_ecount(graph_ptr), this->num_partitions, this->algorithm_vector, this->num_processors);
+    this->memory_plan = memory_planner.Plan(this->max_memory, iterative, streaming_possible, Consensus::voting_flag);
+    Consensus::voting_maps_flag = this->memory_plan.voting_maps;
+    this->WriteToLogFile("Memory plan for a budget of " + std::to_string(this->max_memory) + " bytes: " + this->memory_plan.Describe() + ", predicted peak " + std::to_string(this->memory_plan.predicted_peak_bytes) + " bytes", 1);
+    if(this->memory_plan.predicted_peak_bytes > this->max_memory) {
+        this->WriteToLogFile("No plan fits in --max-memory, running the smallest one", -1);
+    }
+}
+
+void Consensus::LogMeasuredPeak() {
+    if(this->max_memory == 0) {
+        return;
+    }
+    if(this->memory_plan.predicted_peak_bytes == 0) {
+        this->WriteToLogFile("Measured peak " + std::to_string(MemoryPlanner::GetMeasuredPeakBytes()) + " bytes", 1);
+        return;
+    }
+    this->WriteToLogFile("Predicted peak " + std::to_string(this->memory_plan.predicted_peak_bytes) + " bytes, measured peak " + std::to_string(MemoryPlanner::GetMeasuredPeakBytes()) + " bytes", 1);
+}
+
 int Consensus::WriteToLogFile(std::string message, int message_type) {
     if(this->log_level > 0) {
         std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
@@ -68,18 +312,52 @@ int Consensus::WriteToLogFile(std::string message, int message_type) {
     return 0;
 }
 
-void Consensus::WritePartitionMap(std::map<int, int>& final_partition) {
-    std::ofstream clustering_output(this->output_file);
-    for(auto const& [node_id, cluster_id]: final_partition) {
-        clustering_output << node_id << " " << cluster_id << '\n';
+bool Consensus::WritePartitionMap(std::map<int, int>& final_partition) {
+    return this->WritePartitionMap(final_partition, this->output_file);
+}
+
+bool Consensus::WritePartitionMap(std::map<int, int>& final_partition, std::string output_file) {
+    if(this->pruning || this->reordering) {
+        std::map<int, int> full_partition = this->reordering ? this->reordering->RestoreOrder(final_partition) : final_partition;
+        if(this->pruning) {
+            full_partition = this->pruning->Reattach(full_partition);
+        }
+        int64_t num_nodes = full_partition.empty() ? 0 : full_partition.rbegin()->first + 1;
+        std::vector<uint32_t> labels = MembershipIO::PartitionMapToLabels(full_partition, num_nodes);
+        return this->WriteMembership(labels, output_file);
     }
-    clustering_output.close();
+    // vertex ids are the node ids of the edge-list, so the labels use the identity id map
+    int64_t num_nodes = final_partition.empty() ? 0 : final_partition.rbegin()->first + 1;
+    std::vector<uint32_t> labels = MembershipIO::PartitionMapToLabels(final_partition, num_nodes);
+    return this->WriteMembership(labels, output_file);
+}
+
+bool Consensus::WritePartitionMapWithTranslation(std::map<int, int>& final_partition, igraph_t* graph_ptr) {
+    std::vector<uint32_t> labels = MembershipIO::PartitionMapToLabels(final_partition, igraph_vcount(graph_ptr));
+    return this->WriteMembership(labels, this->output_file, graph_ptr);
 }
 
-void Consensus::WritePartitionMapWithTranslation(std::map<int, int>& final_partition, igraph_t* graph_ptr) {
-    std::ofstream clustering_output(this->output_file);
-    for(auto const& [node_id, cluster_id]: final_partition) {
-        clustering_output << VAS(graph_ptr, "name", node_id) << " " << cluster_id << '\n';
+bool Consensus::WriteMembership(std::vector<uint32_t>& labels, std::string output_file, igraph_t* translation_graph_ptr) {
+    PhaseMetrics::Phase output_phase("output");
+    if(this->relabel_by_size) {
+        ClusteringWriter::RelabelBySize(labels);
+    }
+    bool success;
+    if(this->output_format != "text") {
+        uint64_t id_map = translation_graph_ptr == nullptr ? MembershipIO::identity_id_map : Consensus::GetNodeNameIdMap(translation_graph_ptr);
+        success = MembershipIO::WriteBinaryMembership(output_file, labels, MembershipIO::GetOutputFormatFlags(this->output_format), id_map);
+    } else if(translation_graph_ptr != nullptr) {
+        std::vector<const char*> node_names(labels.size());
+        #pragma omp parallel for schedule(static)
+        for(size_t node_id = 0; node_id < labels.size(); node_id ++) {
+            node_names[node_id] = VAS(translation_graph_ptr, "name", node_id);
+        }
+        success = ClusteringWriter::WriteText(output_file, labels, &node_names);
+    } else {
+        success = ClusteringWriter::WriteText(output_file, labels);
+    }
+    if(!success) {
+        this->WriteToLogFile("Could not write " + output_file, -1);
     }
-    clustering_output.close();
+    return success;
 }
@@ -0,0 +1,90 @@
+#include "csr_graph.h"
+
+CSRGraph::CSRGraph(igraph_t* graph_ptr, const char* weight_attribute, const char* node_size_attribute) {
+    this->num_nodes = igraph_vcount(graph_ptr);
+    int64_t num_edges = igraph_ecount(graph_ptr);
+
+    igraph_vector_int_t edge_vector;
+    igraph_vector_int_init(&edge_vector, 0);
+    igraph_get_edgelist(graph_ptr, &edge_vector, false);
+    igraph_vector_t weight_vector;
+    igraph_vector_init(&weight_vector, 0);
+    if(weight_attribute != nullptr) {
+        igraph_cattribute_EANV(graph_ptr, weight_attribute, igraph_ess_all(IGRAPH_EDGEORDER_ID), &weight_vector);
+    }
+
+    std::vector<int64_t> degree(this->num_nodes, 0);
+    #pragma omp parallel for schedule(static)
+    for(int64_t current_edge = 0; current_edge < num_edges; current_edge ++) {
+        int from_node = VECTOR(edge_vector)[2 * current_edge];
+        int to_node = VECTOR(edge_vector)[2 * current_edge + 1];
+        #pragma omp atomic
+        degree[from_node] ++;
+        if(from_node != to_node) {
+            #pragma omp atomic
+            degree[to_node] ++;
+        }
+    }
+
+    this->offsets.assign(this->num_nodes + 1, 0);
+    for(int node_id = 0; node_id < this->num_nodes; node_id ++) {
+        this->offsets[node_id + 1] = this->offsets[node_id] + degree[node_id];
+    }
+    this->neighbors.resize(this->offsets[this->num_nodes]);
+    this->weights.resize(this->offsets[this->num_nodes]);
+
+    std::vector<int64_t> cursor(this->offsets.begin(), this->offsets.end() - 1);
+    #pragma omp parallel for schedule(static)
+    for(int64_t current_edge = 0; current_edge < num_edges; current_edge ++) {
+        int from_node = VECTOR(edge_vector)[2 * current_edge];
+        int to_node = VECTOR(edge_vector)[2 * current_edge + 1];
+        double edge_weight = (weight_attribute != nullptr) ? VECTOR(weight_vector)[current_edge] : 1.0;
+        int64_t from_position;
+        #pragma omp atomic capture
+        from_position = cursor[from_node] ++;
+        this->neighbors[from_position] = to_node;
+        this->weights[from_position] = edge_weight;
+        if(from_node != to_node) {
+            int64_t to_position;
+            #pragma omp atomic capture
+            to_position = cursor[to_node] ++;
+            this->neighbors[to_position] = from_node;
+            this->weights[to_position] = edge_weight;
+        }
+    }
+    igraph_vector_int_destroy(&edge_vector);
+    igraph_vector_destroy(&weight_vector);
+
+    // rows are filled in a thread dependent order so sort them to keep every kernel deterministic
+    this->node_sizes.assign(this->num_nodes, 1.0);
+    if(node_size_attribute != nullptr) {
+        for(int node_id = 0; node_id < this->num_nodes; node_id ++) {
+            this->node_sizes[node_id] = VAN(graph_ptr, node_size_attribute, node_id);
+        }
+    }
+    this->node_strengths.assign(this->num_nodes, 0.0);
+    #pragma omp parallel
+    {
+        std::vector<std::pair<int, double>> row;
+        #pragma omp for schedule(dynamic, 1024)
+        for(int node_id = 0; node_id < this->num_nodes; node_id ++) {
+            row.clear();
+            for(int64_t i = this->offsets[node_id]; i < this->offsets[node_id + 1]; i ++) {
+                row.push_back({this->neighbors[i], this->weights[i]});
+            }
+            std::sort(row.begin(), row.end());
+            double strength = 0;
+            for(size_t i = 0; i < row.size(); i ++) {
+                this->neighbors[this->offsets[node_id] + i] = row[i].first;
+                this->weights[this->offsets[node_id] + i] = row[i].second;
+                strength += (row[i].first == node_id) ? 2 * row[i].second : row[i].second;
+            }
+            this->node_strengths[node_id] = strength;
+        }
+    }
+
+    this->total_strength = 0;
+    for(int node_id = 0; node_id < this->num_nodes; node_id ++) {
+        this->total_strength += this->node_strengths[node_id];
+    }
+}
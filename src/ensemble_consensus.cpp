@@ -15,6 +15,8 @@ bool EnsembleConsensus::CheckConvergence(igraph_t* lhs_graph_ptr, igraph_t* rhs_
         // Continuing without checking convergence
         return false;
     }
+    PhaseMetrics::Phase convergence_phase("convergence");
+    convergence_phase.edges_processed = igraph_ecount(lhs_graph_ptr);
     igraph_bool_t is_identical;
     igraph_is_same_graph(lhs_graph_ptr, rhs_graph_ptr, &is_identical);
     if(is_identical) {
@@ -31,18 +33,21 @@ bool EnsembleConsensus::CheckConvergence(igraph_t* graph_ptr, double max_weight,
         // Continuing without checking convergence
         return false;
     }
-    int count = 0;
-    int num_edges = 0;
+    PhaseMetrics::Phase convergence_phase("convergence");
+    int64_t count = 0;
+    int64_t num_edges = 0;
     igraph_eit_t eit;
     igraph_eit_create(graph_ptr, igraph_ess_all(IGRAPH_EDGEORDER_ID), &eit);
     for(; !IGRAPH_EIT_END(eit); IGRAPH_EIT_NEXT(eit)) {
-        igraph_real_t current_edge_weight = IGRAPH_EIT_GET(eit);
+        igraph_real_t current_edge_weight = EAN(graph_ptr, "weight", IGRAPH_EIT_GET(eit));
         if (current_edge_weight != 0 && current_edge_weight != max_weight) {
             count ++;
         }
         num_edges ++ ;
     }
     igraph_eit_destroy(&eit);
+    convergence_phase.edges_processed = num_edges;
+    convergence_phase.unsettled_edges = count;
     return count <= this->delta * num_edges;
 }
 
@@ -55,20 +60,28 @@ int EnsembleConsensus::main() {
     this->WriteToLogFile("Started setting the default edge weights for the initial graph" , 1);
     Consensus::SetIgraphAllEdgesWeight(&graph, 1);
     this->WriteToLogFile("Finished setting the default edge weights for the initial graph" , 1);
+    bool iterative = true;
+    bool streaming_possible = false;
+    this->PlanMemory(&graph, iterative, streaming_possible);
 
     int iter_count = 0;
+    // weights are rounded to the build's edge weight type so settled edges compare equal to max_weight
+    EdgeWeightCodec weight_codec = EdgeWeightCodec::FromPartitionWeights(this->weight_vector);
     double max_weight = 0;
     for (unsigned int i = 0; i < this->weight_vector.size(); i ++) {
-        max_weight += this->weight_vector[i];
+        max_weight = weight_codec.AddWeight(max_weight, this->weight_vector[i]);
     }
 
     igraph_t next_graph;
+    this->ResumeFromCheckpoint(&graph, &next_graph, iter_count);
     while (!EnsembleConsensus::CheckConvergence(&graph, &next_graph, max_weight, iter_count) && iter_count < max_iter) {
         if(iter_count != 0) {
             igraph_destroy(&graph);
             igraph_copy(&graph, &next_graph);
         }
         this->WriteToLogFile("Staring iteration: " + std::to_string(iter_count), 1);
+        ScratchArena::Scope iteration_scope;
+        PhaseMetrics::SetIteration(iter_count);
         this->WriteToLogFile("Starting to copy the intermediate graphs", 1);
         if(iter_count != 0) {
             igraph_destroy(&next_graph);
@@ -79,24 +92,54 @@ int EnsembleConsensus::main() {
         Consensus::SetIgraphAllEdgesWeight(&next_graph, 0);
         this->WriteToLogFile("Finsihed setting the edge weight for the intermediate graph", 1);
 
-        std::vector<std::map<int, int>> results;
+        // workers finish in any order, so every result goes to the row of its partition
+        std::vector<std::map<int, int>> results(this->num_partitions);
         std::vector<std::map<int, std::vector<int>>> cluster_to_nodes; // for voting
+        std::pmr::vector<std::pmr::vector<int>> cluster_sizes(iteration_scope.Resource()); // for voting when the maps do not fit
+        if(Consensus::voting_flag && Consensus::voting_maps_flag) {
+            cluster_to_nodes.resize(this->num_partitions);
+        } else if(Consensus::voting_flag) {
+            cluster_sizes.resize(this->num_partitions);
+        }
+        std::unique_ptr<GraphCoarsening> coarsening;
+        if(this->coarsening_flag) {
+            this->WriteToLogFile("Started coarsening the fully agreed edges" , 1);
+            coarsening = std::make_unique<GraphCoarsening>(&graph, max_weight);
+            this->WriteToLogFile("Finished coarsening " + std::to_string(igraph_vcount(&graph)) + " nodes into " + std::to_string(coarsening->NumCoarseNodes()) + " supernodes" , 1);
+        }
         this->WriteToLogFile("Starting workers" , 1);
-        this->StartWorkers(&graph);
+        this->StartWorkers(coarsening ? coarsening->GetCoarseGraph() : &graph);
         while(!Consensus::done_being_clustered_clusterings.empty()) {
-            results.push_back(Consensus::done_being_clustered_clusterings.front());
+            int partition_index = Consensus::done_being_clustered_indices.front();
+            if(coarsening) {
+                results[partition_index] = coarsening->ExpandPartition(Consensus::done_being_clustered_clusterings.front());
+            } else {
+                results[partition_index] = Consensus::done_being_clustered_clusterings.front();
+            }
             Consensus::done_being_clustered_clusterings.pop();
+            Consensus::done_being_clustered_indices.pop();
             //this->WriteToLogFile("")
             // voting requires a cluster ID to membership vector map to know if a node is in a singleton cluster
-            if (Consensus::voting_flag) { // will be in same order right?
-                cluster_to_nodes.push_back(Consensus::done_being_clustered_cluster_to_nodes_map.front());
-                Consensus::done_being_clustered_cluster_to_nodes_map.pop();
+            if (Consensus::voting_flag) { // the maps are queued in the same order as the clusterings
+                // supernode clusters have to be counted again in original nodes
+                if(!Consensus::voting_maps_flag) {
+                    EnsembleConsensus::GetClusterSizes(results[partition_index], cluster_sizes[partition_index]);
+                } else if(coarsening) {
+                    cluster_to_nodes[partition_index] = Consensus::GetClusterToNodeMap(results[partition_index]);
+                    Consensus::done_being_clustered_cluster_to_nodes_map.pop();
+                } else {
+                    cluster_to_nodes[partition_index] = Consensus::done_being_clustered_cluster_to_nodes_map.front();
+                    Consensus::done_being_clustered_cluster_to_nodes_map.pop();
+                }
             }
         }
+        coarsening.reset();
 
         this->WriteToLogFile("Got results back from workers" , 1);
         int tmp_counter = 0;
 
+        PhaseMetrics::Phase accumulation_phase("accumulation");
+        accumulation_phase.edges_processed = igraph_ecount(&graph) * this->num_partitions;
         igraph_eit_t eit;
         igraph_eit_create(&graph, igraph_ess_all(IGRAPH_EDGEORDER_ID), &eit);
         for(; !IGRAPH_EIT_END(eit); IGRAPH_EIT_NEXT(eit)) {
@@ -118,9 +161,12 @@ int EnsembleConsensus::main() {
                 for(int i = 0; i < this->num_partitions; i++) {
 
                     if(results.at(i).at(from_node) == results.at(i).at(to_node)) {
-                        next_graph_edge_weight += (1 * (this->weight_vector[i]));
+                        next_graph_edge_weight = weight_codec.AddWeight(next_graph_edge_weight, this->weight_vector[i]);
                     }
-                    if(Consensus::voting_flag) {
+                    if(Consensus::voting_flag && !Consensus::voting_maps_flag) {
+                        if(cluster_sizes.at(i).at(results.at(i).at(from_node)) > 1 && cluster_sizes.at(i).at(results.at(i).at(to_node)) > 1)
+                            partition_inclusion_count += 1;
+                    } else if(Consensus::voting_flag) {
                         // check if the partition should vote
                         if(cluster_to_nodes.at(i).at(results.at(i).at(from_node)).size() > 1 
                         && cluster_to_nodes.at(i).at(results.at(i).at(to_node)).size() > 1)                             
@@ -128,23 +174,33 @@ int EnsembleConsensus::main() {
                     } else partition_inclusion_count +=1;
                 }
                 float multiplier = static_cast<float>(num_partitions)/partition_inclusion_count;
-                SETEAN(&next_graph, "weight", next_graph_current_edge, next_graph_edge_weight*multiplier);
+                SETEAN(&next_graph, "weight", next_graph_current_edge, weight_codec.ScaleWeight(next_graph_edge_weight, multiplier));
             } else {
                 SETEAN(&next_graph, "weight", next_graph_current_edge, graph_edge_weight);
             }
         }
         igraph_eit_destroy(&eit);
+        accumulation_phase.Finish();
         //this->WriteToLogFile("Finished incorpating results from worker: " + std::to_string(i) , 1);
         
         this->WriteToLogFile("Started removing edges from the intermediate graph" , 1);
-        Consensus::RemoveEdgesBasedOnThreshold(&next_graph, this->threshold * max_weight);
+        PhaseMetrics::Phase threshold_phase("threshold");
+        threshold_phase.edges_processed = igraph_ecount(&next_graph);
+        Consensus::RemoveEdgesBasedOnThreshold(&next_graph, weight_codec.FromWeightThreshold(this->threshold, max_weight));
+        threshold_phase.edges_surviving = igraph_ecount(&next_graph);
+        threshold_phase.Finish();
         this->WriteToLogFile("Finished removing edges from the intermediate graph" , 1);
         iter_count ++;
+        this->CheckpointIteration(&graph, &next_graph, iter_count);
     }
+    this->checkpoint_writer.reset();
+    PhaseMetrics::SetIteration(-1);
 
 
     this->WriteToLogFile("Ensemble consensus took " + std::to_string(iter_count) + " iterations", 1);
     std::map<int, int> final_partition;
+    PhaseMetrics::Phase final_clustering_phase("final_clustering");
+    final_clustering_phase.edges_processed = igraph_ecount(&next_graph);
     if(this->final_clustering_flag) {
         this->WriteToLogFile("Started the final connected components run" , 1);
         final_partition = Consensus::GetConnectedComponents(&next_graph);
@@ -154,6 +210,7 @@ int EnsembleConsensus::main() {
         final_partition = Consensus::GetCommunities("", this->final_algorithm, 0, this->final_resolution, &next_graph);
                 this->WriteToLogFile("Finished the final clustering run" , 1);
     }
+    final_clustering_phase.Finish();
 
     igraph_destroy(&graph);
     if(iter_count != 0) {
@@ -161,9 +218,10 @@ int EnsembleConsensus::main() {
     }
 
     this->WriteToLogFile("Started writing to the output clustering file" , 1);
-    this->WritePartitionMap(final_partition);
+    bool write_success = this->WritePartitionMap(final_partition);
     this->WriteToLogFile("Finished writing to the output clustering file" , 1);
+    this->LogMeasuredPeak();
 
 
-    return 0;
+    return write_success ? 0 : 1;
 }
@@ -0,0 +1,55 @@
+#include "ensemble_generator.h"
+
+#include <filesystem>
+
+std::string EnsembleGenerator::GetShardFile(std::string shard_directory, int partition_index) {
+    return (std::filesystem::path(shard_directory) / ("partition." + std::to_string(partition_index) + ".ccmb")).string();
+}
+
+int EnsembleGenerator::main() {
+    if(this->last_partition == -1) {
+        this->last_partition = this->num_partitions - 1;
+    }
+    if(this->first_partition < 0 || this->first_partition > this->last_partition || this->last_partition >= this->num_partitions) {
+        this->WriteToLogFile("Partition range " + std::to_string(this->first_partition) + "-" + std::to_string(this->last_partition) + " is outside of the partition file", -1);
+        return 1;
+    }
+    // loaded like threshold so the shards are the partitions threshold would compute itself
+    this->WriteToLogFile("Loading the graph" , 1);
+    igraph_t graph;
+    igraph_set_attribute_table(&igraph_cattribute_table);
+    bool simplify = false;
+    this->ReadEdgelist(&graph, simplify);
+    this->WriteToLogFile("Finished loading the graph" , 1);
+
+    this->WriteToLogFile("Starting workers for partitions " + std::to_string(this->first_partition) + " to " + std::to_string(this->last_partition), 1);
+    this->StartWorkers(&graph, this->first_partition, this->last_partition);
+    this->WriteToLogFile("Got results back from workers" , 1);
+
+    PhaseMetrics::Phase output_phase("output");
+    std::filesystem::create_directories(this->output_file);
+    int64_t num_nodes = igraph_vcount(&graph);
+    int exit_code = 0;
+    while(!Consensus::done_being_clustered_clusterings.empty()) {
+        int partition_index = Consensus::done_being_clustered_indices.front();
+        std::string shard_file = EnsembleGenerator::GetShardFile(this->output_file, partition_index);
+        // shards are renamed into place so reduce never picks up a partial one
+        std::string temporary_file = shard_file + ".tmp";
+        bool success = MembershipIO::WriteBinaryMembership(temporary_file, MembershipIO::PartitionMapToLabels(Consensus::done_being_clustered_clusterings.front(), num_nodes), MembershipIO::varint_flag);
+        if(success) {
+            std::error_code rename_error;
+            std::filesystem::rename(temporary_file, shard_file, rename_error);
+            success = !rename_error;
+        }
+        if(success) {
+            this->WriteToLogFile("Wrote partition " + std::to_string(partition_index) + " to " + shard_file, 1);
+        } else {
+            this->WriteToLogFile("Could not write partition " + std::to_string(partition_index) + " to " + shard_file, -1);
+            exit_code = 1;
+        }
+        Consensus::done_being_clustered_clusterings.pop();
+        Consensus::done_being_clustered_indices.pop();
+    }
+    igraph_destroy(&graph);
+    return exit_code;
+}
@@ -0,0 +1,117 @@
+#include "graph_coarsening.h"
+
+#include <algorithm>
+
+GraphCoarsening::GraphCoarsening(igraph_t* graph_ptr, double max_weight) {
+    int num_nodes = igraph_vcount(graph_ptr);
+    igraph_integer_t num_edges = igraph_ecount(graph_ptr);
+    igraph_vector_t weight_vector;
+    igraph_vector_init(&weight_vector, 0);
+    igraph_cattribute_EANV(graph_ptr, "weight", igraph_ess_all(IGRAPH_EDGEORDER_ID), &weight_vector);
+
+    ConcurrentUnionFind union_find(num_nodes);
+    #pragma omp parallel for schedule(dynamic, 4096)
+    for(igraph_integer_t current_edge = 0; current_edge < num_edges; current_edge ++) {
+        if(VECTOR(weight_vector)[current_edge] == max_weight) {
+            union_find.Union(IGRAPH_FROM(graph_ptr, current_edge), IGRAPH_TO(graph_ptr, current_edge));
+        }
+    }
+    igraph_vector_destroy(&weight_vector);
+
+    igraph_vector_int_t degree_vector;
+    igraph_vector_int_init(&degree_vector, 0);
+    igraph_degree(graph_ptr, &degree_vector, igraph_vss_all(), IGRAPH_ALL, true);
+    this->has_edge.resize(num_nodes);
+    for(int node_id = 0; node_id < num_nodes; node_id ++) {
+        this->has_edge[node_id] = VECTOR(degree_vector)[node_id] > 0;
+    }
+    igraph_vector_int_destroy(&degree_vector);
+    std::vector<int> coarse_node_sizes;
+    this->num_coarse_nodes = union_find.GetComponents(this->coarse_node_ids, coarse_node_sizes);
+
+    // every coarse edge is bucketed under its smaller endpoint so the buckets can be merged independently
+    std::vector<int64_t> bucket_offsets(this->num_coarse_nodes + 1, 0);
+    #pragma omp parallel for schedule(static)
+    for(igraph_integer_t current_edge = 0; current_edge < num_edges; current_edge ++) {
+        int from_coarse_node = this->coarse_node_ids[IGRAPH_FROM(graph_ptr, current_edge)];
+        int to_coarse_node = this->coarse_node_ids[IGRAPH_TO(graph_ptr, current_edge)];
+        #pragma omp atomic
+        bucket_offsets[std::min(from_coarse_node, to_coarse_node) + 1] ++;
+    }
+    for(int i = 0; i < this->num_coarse_nodes; i ++) {
+        bucket_offsets[i + 1] += bucket_offsets[i];
+    }
+    std::vector<int> bucket_neighbors(num_edges);
+    std::vector<int64_t> cursor(bucket_offsets.begin(), bucket_offsets.end() - 1);
+    #pragma omp parallel for schedule(static)
+    for(igraph_integer_t current_edge = 0; current_edge < num_edges; current_edge ++) {
+        int from_coarse_node = this->coarse_node_ids[IGRAPH_FROM(graph_ptr, current_edge)];
+        int to_coarse_node = this->coarse_node_ids[IGRAPH_TO(graph_ptr, current_edge)];
+        int64_t position;
+        #pragma omp atomic capture
+        position = cursor[std::min(from_coarse_node, to_coarse_node)] ++;
+        bucket_neighbors[position] = std::max(from_coarse_node, to_coarse_node);
+    }
+
+    std::vector<int64_t> coarse_edge_offsets(this->num_coarse_nodes + 1, 0);
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for(int coarse_node = 0; coarse_node < this->num_coarse_nodes; coarse_node ++) {
+        std::sort(bucket_neighbors.begin() + bucket_offsets[coarse_node], bucket_neighbors.begin() + bucket_offsets[coarse_node + 1]);
+        int64_t num_distinct_neighbors = 0;
+        for(int64_t i = bucket_offsets[coarse_node]; i < bucket_offsets[coarse_node + 1]; i ++) {
+            if(i == bucket_offsets[coarse_node] || bucket_neighbors[i] != bucket_neighbors[i - 1]) {
+                num_distinct_neighbors ++;
+            }
+        }
+        coarse_edge_offsets[coarse_node + 1] = num_distinct_neighbors;
+    }
+    for(int i = 0; i < this->num_coarse_nodes; i ++) {
+        coarse_edge_offsets[i + 1] += coarse_edge_offsets[i];
+    }
+
+    // parallel edges become one edge weighted by their number, in order of the smaller endpoint
+    int64_t num_coarse_edges = coarse_edge_offsets[this->num_coarse_nodes];
+    igraph_vector_int_t coarse_edge_vector;
+    igraph_vector_int_init(&coarse_edge_vector, 2 * num_coarse_edges);
+    igraph_vector_t coarse_weight_vector;
+    igraph_vector_init(&coarse_weight_vector, num_coarse_edges);
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for(int coarse_node = 0; coarse_node < this->num_coarse_nodes; coarse_node ++) {
+        int64_t coarse_edge = coarse_edge_offsets[coarse_node] - 1;
+        for(int64_t i = bucket_offsets[coarse_node]; i < bucket_offsets[coarse_node + 1]; i ++) {
+            if(i == bucket_offsets[coarse_node] || bucket_neighbors[i] != bucket_neighbors[i - 1]) {
+                coarse_edge ++;
+                VECTOR(coarse_edge_vector)[2 * coarse_edge] = coarse_node;
+                VECTOR(coarse_edge_vector)[2 * coarse_edge + 1] = bucket_neighbors[i];
+            }
+            VECTOR(coarse_weight_vector)[coarse_edge] += 1;
+        }
+    }
+    igraph_create(&this->coarse_graph, &coarse_edge_vector, this->num_coarse_nodes, IGRAPH_UNDIRECTED);
+    igraph_vector_int_destroy(&coarse_edge_vector);
+    SETEANV(&this->coarse_graph, "coarse_weight", &coarse_weight_vector);
+    igraph_vector_destroy(&coarse_weight_vector);
+
+    igraph_vector_t coarse_size_vector;
+    igraph_vector_init(&coarse_size_vector, this->num_coarse_nodes);
+    for(int coarse_node = 0; coarse_node < this->num_coarse_nodes; coarse_node ++) {
+        VECTOR(coarse_size_vector)[coarse_node] = coarse_node_sizes[coarse_node];
+    }
+    SETVANV(&this->coarse_graph, "coarse_size", &coarse_size_vector);
+    igraph_vector_destroy(&coarse_size_vector);
+}
+
+std::map<int, int> GraphCoarsening::ExpandPartition(const std::map<int, int>& coarse_partition_map) const {
+    std::vector<int> coarse_labels(this->num_coarse_nodes, -1);
+    for(auto const& [coarse_node, cluster_id] : coarse_partition_map) {
+        coarse_labels[coarse_node] = cluster_id;
+    }
+    std::map<int, int> partition_map;
+    for(size_t node_id = 0; node_id < this->coarse_node_ids.size(); node_id ++) {
+        int cluster_id = coarse_labels[this->coarse_node_ids[node_id]];
+        if(this->has_edge[node_id] && cluster_id != -1) {
+            partition_map.emplace_hint(partition_map.end(), node_id, cluster_id);
+        }
+    }
+    return partition_map;
+}
@@ -0,0 +1,264 @@
+#include "graph_pruning.h"
+
+#include <algorithm>
+
+namespace {
+    // thread local results are concatenated in thread order
+    template<typename T>
+    void Concatenate(std::vector<std::vector<T>>& thread_vectors, std::vector<T>& result) {
+        result.clear();
+        for(auto& thread_vector : thread_vectors) {
+            result.insert(result.end(), std::make_move_iterator(thread_vector.begin()), std::make_move_iterator(thread_vector.end()));
+            thread_vector.clear();
+        }
+    }
+}
+
+GraphPruning::GraphPruning(igraph_t* graph_ptr, bool peel_paths) : num_nodes(igraph_vcount(graph_ptr)), degree(igraph_vcount(graph_ptr)) {
+    CSRGraph graph(graph_ptr);
+    this->peeled.assign(this->num_nodes, 0);
+    this->anchor.assign(this->num_nodes, GraphPruning::not_peeled);
+    // self loops do not hold a node in the core
+    #pragma omp parallel for schedule(static)
+    for(int node_id = 0; node_id < this->num_nodes; node_id ++) {
+        int node_degree = 0;
+        for(int64_t i = graph.offsets[node_id]; i < graph.offsets[node_id + 1]; i ++) {
+            if(graph.neighbors[i] != node_id) {
+                node_degree ++;
+            }
+        }
+        this->degree[node_id].store(node_degree, std::memory_order_relaxed);
+    }
+
+    this->PeelTrees(graph);
+    if(peel_paths) {
+        this->PeelPaths(graph);
+    }
+
+    // peeled nodes lose all their edges and every path is replaced by one edge between its ends
+    igraph_integer_t num_edges = igraph_ecount(graph_ptr);
+    std::vector<char> remove_edge(num_edges, 0);
+    #pragma omp parallel for schedule(static)
+    for(igraph_integer_t current_edge = 0; current_edge < num_edges; current_edge ++) {
+        remove_edge[current_edge] = this->peeled[IGRAPH_FROM(graph_ptr, current_edge)] || this->peeled[IGRAPH_TO(graph_ptr, current_edge)];
+    }
+    igraph_vector_int_t edges_to_remove;
+    igraph_vector_int_init(&edges_to_remove, 0);
+    for(igraph_integer_t current_edge = 0; current_edge < num_edges; current_edge ++) {
+        if(remove_edge[current_edge]) {
+            igraph_vector_int_push_back(&edges_to_remove, current_edge);
+        }
+    }
+    igraph_es_t es;
+    igraph_es_vector_copy(&es, &edges_to_remove);
+    igraph_delete_edges(graph_ptr, es);
+    igraph_es_destroy(&es);
+    igraph_vector_int_destroy(&edges_to_remove);
+
+    // ends of peeled paths are never adjacent and no two peeled paths share both ends, so every shortcut is new
+    igraph_vector_int_t edges_to_add;
+    igraph_vector_int_init(&edges_to_add, 0);
+    for(auto const& path : this->paths) {
+        igraph_vector_int_push_back(&edges_to_add, std::min(path.first_end, path.second_end));
+        igraph_vector_int_push_back(&edges_to_add, std::max(path.first_end, path.second_end));
+    }
+    igraph_add_edges(graph_ptr, &edges_to_add, NULL);
+    igraph_vector_int_destroy(&edges_to_add);
+}
+
+void GraphPruning::PeelTrees(const CSRGraph& graph) {
+    std::vector<int> removal_round(this->num_nodes, -1);
+    int num_threads = omp_get_max_threads();
+    std::vector<std::vector<int>> thread_frontiers(num_threads);
+    std::vector<int> frontier;
+    #pragma omp parallel num_threads(num_threads)
+    {
+        std::vector<int>& thread_frontier = thread_frontiers[omp_get_thread_num()];
+        #pragma omp for schedule(static)
+        for(int node_id = 0; node_id < this->num_nodes; node_id ++) {
+            if(this->degree[node_id].load(std::memory_order_relaxed) == 1) {
+                thread_frontier.push_back(node_id);
+            }
+        }
+    }
+    Concatenate(thread_frontiers, frontier);
+
+    for(int round = 0; !frontier.empty(); round ++) {
+        #pragma omp parallel for schedule(static)
+        for(size_t i = 0; i < frontier.size(); i ++) {
+            removal_round[frontier[i]] = round;
+            this->peeled[frontier[i]] = 1;
+        }
+        #pragma omp parallel num_threads(num_threads)
+        {
+            std::vector<int>& thread_frontier = thread_frontiers[omp_get_thread_num()];
+            #pragma omp for schedule(dynamic, 256)
+            for(size_t i = 0; i < frontier.size(); i ++) {
+                int node_id = frontier[i];
+                if(this->degree[node_id].load(std::memory_order_relaxed) == 0) {
+                    // every other node of its tree was peeled in the previous round
+                    this->anchor[node_id] = GraphPruning::tree_root;
+                    continue;
+                }
+                int remaining_neighbor = -1;
+                for(int64_t j = graph.offsets[node_id]; j < graph.offsets[node_id + 1]; j ++) {
+                    int neighbor = graph.neighbors[j];
+                    if(neighbor != node_id && (removal_round[neighbor] == -1 || removal_round[neighbor] == round)) {
+                        remaining_neighbor = neighbor;
+                        break;
+                    }
+                }
+                if(removal_round[remaining_neighbor] == round) {
+                    // a two node tree peeled from both sides at once hangs from its smaller node
+                    this->anchor[node_id] = (node_id < remaining_neighbor) ? GraphPruning::tree_root : remaining_neighbor;
+                    continue;
+                }
+                this->anchor[node_id] = remaining_neighbor;
+                if(this->degree[remaining_neighbor].fetch_sub(1, std::memory_order_relaxed) == 2) {
+                    thread_frontier.push_back(remaining_neighbor);
+                }
+            }
+        }
+        this->num_tree_nodes += frontier.size();
+        this->peeling_rounds.push_back(std::move(frontier));
+        Concatenate(thread_frontiers, frontier);
+    }
+}
+
+void GraphPruning::PeelPaths(const CSRGraph& graph) {
+    auto is_path_node = [this](int node_id) {
+        return !this->peeled[node_id] && this->degree[node_id].load(std::memory_order_relaxed) == 2;
+    };
+    auto remaining_neighbors = [this, &graph](int node_id, int* neighbors) {
+        int num_found = 0;
+        for(int64_t i = graph.offsets[node_id]; i < graph.offsets[node_id + 1] && num_found < 2; i ++) {
+            int neighbor = graph.neighbors[i];
+            if(neighbor != node_id && !this->peeled[neighbor]) {
+                neighbors[num_found ++] = neighbor;
+            }
+        }
+    };
+
+    int num_threads = omp_get_max_threads();
+    std::vector<std::vector<Path>> thread_paths(num_threads);
+    #pragma omp parallel num_threads(num_threads)
+    {
+        std::vector<Path>& current_thread_paths = thread_paths[omp_get_thread_num()];
+        #pragma omp for schedule(dynamic, 1024)
+        for(int node_id = 0; node_id < this->num_nodes; node_id ++) {
+            if(!is_path_node(node_id)) {
+                continue;
+            }
+            int start_neighbors[2];
+            remaining_neighbors(node_id, start_neighbors);
+            for(int slot = 0; slot < 2; slot ++) {
+                int first_end = start_neighbors[slot];
+                if(is_path_node(first_end)) {
+                    continue;
+                }
+                // walk away from the end until the next node that is not on a path
+                Path path;
+                path.first_end = first_end;
+                int previous = first_end;
+                int current = node_id;
+                while(is_path_node(current)) {
+                    path.nodes.push_back(current);
+                    int current_neighbors[2];
+                    remaining_neighbors(current, current_neighbors);
+                    int next = (current_neighbors[0] == previous) ? current_neighbors[1] : current_neighbors[0];
+                    previous = current;
+                    current = next;
+                }
+                path.second_end = current;
+                // paths closing a cycle on one end or running parallel to an edge hold their ends together and stay
+                auto end_row_begin = graph.neighbors.begin() + graph.offsets[path.first_end];
+                auto end_row_end = graph.neighbors.begin() + graph.offsets[path.first_end + 1];
+                if(path.first_end == path.second_end || std::binary_search(end_row_begin, end_row_end, path.second_end)) {
+                    continue;
+                }
+                // each path is walked from both of its ends, only the walk from the smaller side keeps it
+                std::pair<int, int> first_side = {path.first_end, path.nodes.front()};
+                std::pair<int, int> second_side = {path.second_end, path.nodes.back()};
+                if(first_side < second_side || (first_side == second_side && slot == 0)) {
+                    current_thread_paths.push_back(std::move(path));
+                }
+            }
+        }
+    }
+    Concatenate(thread_paths, this->paths);
+    // several paths between the same two ends form a cycle through both of them, so they stay like the ones above
+    auto get_ends = [](const Path& path) {
+        return std::make_pair(std::min(path.first_end, path.second_end), std::max(path.first_end, path.second_end));
+    };
+    std::vector<std::pair<int, int>> path_ends;
+    for(auto const& path : this->paths) {
+        path_ends.push_back(get_ends(path));
+    }
+    std::sort(path_ends.begin(), path_ends.end());
+    this->paths.erase(std::remove_if(this->paths.begin(), this->paths.end(), [&path_ends, &get_ends](const Path& path) {
+        auto [range_begin, range_end] = std::equal_range(path_ends.begin(), path_ends.end(), get_ends(path));
+        return range_end - range_begin > 1;
+    }), this->paths.end());
+    std::sort(this->paths.begin(), this->paths.end(), [](const Path& lhs, const Path& rhs) {
+        return std::make_pair(lhs.first_end, lhs.nodes.front()) < std::make_pair(rhs.first_end, rhs.nodes.front());
+    });
+    for(auto const& path : this->paths) {
+        for(int node_id : path.nodes) {
+            this->peeled[node_id] = 1;
+        }
+        this->num_path_nodes += path.nodes.size();
+    }
+}
+
+std::map<int, int> GraphPruning::Reattach(const std::map<int, int>& core_partition_map) const {
+    std::vector<int> labels(this->num_nodes, -1);
+    int next_cluster_id = 0;
+    for(auto const& [node_id, cluster_id] : core_partition_map) {
+        labels[node_id] = cluster_id;
+        next_cluster_id = std::max(next_cluster_id, cluster_id + 1);
+    }
+
+    #pragma omp parallel for schedule(dynamic, 64)
+    for(size_t i = 0; i < this->paths.size(); i ++) {
+        const Path& path = this->paths[i];
+        int first_label = labels[path.first_end];
+        int second_label = labels[path.second_end];
+        int64_t path_length = path.nodes.size();
+        for(int64_t position = 0; position < path_length; position ++) {
+            bool first_is_nearer = position + 1 <= path_length - position;
+            labels[path.nodes[position]] = (first_label == second_label || first_is_nearer) ? first_label : second_label;
+        }
+    }
+
+    // tree components get new clusters numbered by their root
+    std::vector<int> tree_roots;
+    for(auto const& peeling_round : this->peeling_rounds) {
+        for(int node_id : peeling_round) {
+            if(this->anchor[node_id] == GraphPruning::tree_root) {
+                tree_roots.push_back(node_id);
+            }
+        }
+    }
+    std::sort(tree_roots.begin(), tree_roots.end());
+    for(int node_id : tree_roots) {
+        labels[node_id] = next_cluster_id ++;
+    }
+    // anchors were peeled in a later round or are tree roots, so walking the rounds backwards resolves them
+    for(auto peeling_round = this->peeling_rounds.rbegin(); peeling_round != this->peeling_rounds.rend(); peeling_round ++) {
+        #pragma omp parallel for schedule(static)
+        for(size_t i = 0; i < peeling_round->size(); i ++) {
+            int node_id = (*peeling_round)[i];
+            if(this->anchor[node_id] != GraphPruning::tree_root) {
+                labels[node_id] = labels[this->anchor[node_id]];
+            }
+        }
+    }
+
+    std::map<int, int> partition_map(core_partition_map);
+    for(int node_id = 0; node_id < this->num_nodes; node_id ++) {
+        if(this->peeled[node_id] && labels[node_id] != -1) {
+            partition_map[node_id] = labels[node_id];
+        }
+    }
+    return partition_map;
+}
@@ -0,0 +1,139 @@
+#include "graph_reordering.h"
+
+#include <algorithm>
+#include <numeric>
+
+GraphReordering::GraphReordering(igraph_t* graph_ptr, std::string ordering) {
+    CSRGraph graph(graph_ptr);
+    if(ordering == "degree") {
+        this->original_ids = this->DegreeOrder(graph);
+    } else if(ordering == "rcm") {
+        this->original_ids = this->ReverseCuthillMcKeeOrder(graph);
+    } else {
+        this->original_ids = this->CommunityOrder(graph);
+    }
+    this->new_ids.resize(graph.num_nodes);
+    #pragma omp parallel for schedule(static)
+    for(int new_id = 0; new_id < graph.num_nodes; new_id ++) {
+        this->new_ids[this->original_ids[new_id]] = new_id;
+    }
+    this->Rebuild(graph_ptr, graph);
+}
+
+std::vector<int> GraphReordering::DegreeOrder(const CSRGraph& graph) const {
+    std::vector<int> order(graph.num_nodes);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&graph](int lhs, int rhs) {
+        return graph.Degree(lhs) > graph.Degree(rhs);
+    });
+    return order;
+}
+
+std::vector<int> GraphReordering::ReverseCuthillMcKeeOrder(const CSRGraph& graph) const {
+    // every component starts from its first vertex of minimum degree
+    std::vector<int> start_candidates(graph.num_nodes);
+    std::iota(start_candidates.begin(), start_candidates.end(), 0);
+    std::stable_sort(start_candidates.begin(), start_candidates.end(), [&graph](int lhs, int rhs) {
+        return graph.Degree(lhs) < graph.Degree(rhs);
+    });
+    std::vector<int> order;
+    order.reserve(graph.num_nodes);
+    std::vector<char> visited(graph.num_nodes, 0);
+    std::vector<int> unvisited_neighbors;
+    for(int start_node : start_candidates) {
+        if(visited[start_node]) {
+            continue;
+        }
+        visited[start_node] = 1;
+        size_t queue_front = order.size();
+        order.push_back(start_node);
+        while(queue_front < order.size()) {
+            int node_id = order[queue_front ++];
+            unvisited_neighbors.clear();
+            for(int64_t i = graph.offsets[node_id]; i < graph.offsets[node_id + 1]; i ++) {
+                int neighbor = graph.neighbors[i];
+                if(!visited[neighbor]) {
+                    visited[neighbor] = 1;
+                    unvisited_neighbors.push_back(neighbor);
+                }
+            }
+            std::stable_sort(unvisited_neighbors.begin(), unvisited_neighbors.end(), [&graph](int lhs, int rhs) {
+                return graph.Degree(lhs) < graph.Degree(rhs);
+            });
+            order.insert(order.end(), unvisited_neighbors.begin(), unvisited_neighbors.end());
+        }
+    }
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+std::vector<int> GraphReordering::CommunityOrder(CSRGraph& graph) const {
+    LabelPropagation label_propagation(&graph, 0);
+    std::vector<int> labels = label_propagation.Run();
+    // communities are laid out in the order of their smallest vertex
+    std::vector<int> community_position(graph.num_nodes, graph.num_nodes);
+    for(int node_id = graph.num_nodes - 1; node_id >= 0; node_id --) {
+        community_position[labels[node_id]] = node_id;
+    }
+    std::vector<int> order(graph.num_nodes);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&labels, &community_position](int lhs, int rhs) {
+        return community_position[labels[lhs]] < community_position[labels[rhs]];
+    });
+    return order;
+}
+
+void GraphReordering::Rebuild(igraph_t* graph_ptr, const CSRGraph& graph) const {
+    // every edge is emitted from the row of its smaller new endpoint so the new edge list comes out sorted by source
+    std::vector<int64_t> row_offsets(graph.num_nodes + 1, 0);
+    #pragma omp parallel for schedule(static)
+    for(int new_id = 0; new_id < graph.num_nodes; new_id ++) {
+        int original_id = this->original_ids[new_id];
+        int64_t row_size = 0;
+        for(int64_t i = graph.offsets[original_id]; i < graph.offsets[original_id + 1]; i ++) {
+            if(new_id <= this->new_ids[graph.neighbors[i]]) {
+                row_size ++;
+            }
+        }
+        row_offsets[new_id + 1] = row_size;
+    }
+    for(int new_id = 0; new_id < graph.num_nodes; new_id ++) {
+        row_offsets[new_id + 1] += row_offsets[new_id];
+    }
+
+    igraph_vector_int_t edge_vector;
+    igraph_vector_int_init(&edge_vector, 2 * row_offsets[graph.num_nodes]);
+    #pragma omp parallel
+    {
+        std::vector<int> row;
+        #pragma omp for schedule(dynamic, 1024)
+        for(int new_id = 0; new_id < graph.num_nodes; new_id ++) {
+            int original_id = this->original_ids[new_id];
+            row.clear();
+            for(int64_t i = graph.offsets[original_id]; i < graph.offsets[original_id + 1]; i ++) {
+                int neighbor = this->new_ids[graph.neighbors[i]];
+                if(new_id <= neighbor) {
+                    row.push_back(neighbor);
+                }
+            }
+            std::sort(row.begin(), row.end());
+            for(size_t i = 0; i < row.size(); i ++) {
+                VECTOR(edge_vector)[2 * (row_offsets[new_id] + i)] = new_id;
+                VECTOR(edge_vector)[2 * (row_offsets[new_id] + i) + 1] = row[i];
+            }
+        }
+    }
+    igraph_t reordered_graph;
+    igraph_create(&reordered_graph, &edge_vector, graph.num_nodes, IGRAPH_UNDIRECTED);
+    igraph_vector_int_destroy(&edge_vector);
+    igraph_destroy(graph_ptr);
+    *graph_ptr = reordered_graph;
+}
+
+std::map<int, int> GraphReordering::RestoreOrder(const std::map<int, int>& partition_map) const {
+    std::map<int, int> original_partition_map;
+    for(auto const& [node_id, cluster_id] : partition_map) {
+        original_partition_map[this->original_ids[node_id]] = cluster_id;
+    }
+    return original_partition_map;
+}
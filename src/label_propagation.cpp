@@ -0,0 +1,70 @@
+#include "label_propagation.h"
+
+std::vector<int> LabelPropagation::Run(int max_rounds) {
+    const CSRGraph& graph = *this->graph_ptr;
+    int num_nodes = graph.num_nodes;
+    std::vector<int> labels(num_nodes);
+    for(int node_id = 0; node_id < num_nodes; node_id ++) {
+        labels[node_id] = node_id;
+    }
+    std::vector<int> next_labels(labels);
+
+    int rounds_without_change = 0;
+    for(int round = 0; round < max_rounds; round ++) {
+        int64_t num_changed = 0;
+        #pragma omp parallel
+        {
+            std::vector<std::pair<int, double>> neighbor_labels;
+            #pragma omp for schedule(dynamic, 1024) reduction(+:num_changed)
+            for(int node_id = 0; node_id < num_nodes; node_id ++) {
+                int current_label = labels[node_id];
+                next_labels[node_id] = current_label;
+                if((HashVertex(this->seed, round, node_id) & 1) == 0) {
+                    continue;
+                }
+                neighbor_labels.clear();
+                for(int64_t i = graph.offsets[node_id]; i < graph.offsets[node_id + 1]; i ++) {
+                    int neighbor = graph.neighbors[i];
+                    if(neighbor != node_id) {
+                        neighbor_labels.push_back({labels[neighbor], graph.weights[i]});
+                    }
+                }
+                if(neighbor_labels.empty()) {
+                    continue;
+                }
+                std::sort(neighbor_labels.begin(), neighbor_labels.end());
+
+                // ties keep the current label, otherwise they go to the label with the smallest seeded hash
+                int best_label = current_label;
+                double best_weight = -1;
+                uint64_t best_priority = 0;
+                for(size_t i = 0; i < neighbor_labels.size(); ) {
+                    int label = neighbor_labels[i].first;
+                    double label_weight = 0;
+                    for(; i < neighbor_labels.size() && neighbor_labels[i].first == label; i ++) {
+                        label_weight += neighbor_labels[i].second;
+                    }
+                    uint64_t priority = HashVertex(this->seed, round, label);
+                    bool better = label_weight > best_weight
+                        || (label_weight == best_weight && best_label != current_label && (label == current_label || priority < best_priority));
+                    if(better) {
+                        best_label = label;
+                        best_weight = label_weight;
+                        best_priority = priority;
+                    }
+                }
+                if(best_label != current_label) {
+                    next_labels[node_id] = best_label;
+                    num_changed ++;
+                }
+            }
+        }
+        labels.swap(next_labels);
+        // a quiet round only covered half of the nodes
+        rounds_without_change = (num_changed == 0) ? rounds_without_change + 1 : 0;
+        if(rounds_without_change == 2) {
+            break;
+        }
+    }
+    return labels;
+}
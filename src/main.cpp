@@ -7,6 +7,7 @@
 #include "threshold_consensus.h"
 #include "simple_ensemble_clustering.h"
 #include "ensemble_consensus.h"
+#include "ensemble_generator.h"
 
 int main(int argc, char* argv[]) {
     argparse::ArgumentParser main_program("consensus-clustering");
@@ -25,6 +26,51 @@ int main(int argc, char* argv[]) {
     argparse::ArgumentParser ensemble_consensus("ensemble_consensus");
     ensemble_consensus.add_description("Ensemble consensus clustering algorithm");
 
+    argparse::ArgumentParser generate("generate");
+    generate.add_description("Compute a range of the partitions of a partition file and write them to a shard directory");
+
+    argparse::ArgumentParser reduce("reduce");
+    reduce.add_description("Threshold consensus over the partitions written to a shard directory by generate");
+
+    auto output_format_action = [](const std::string& value) {
+        static const std::vector<std::string> choices = {"text", "binary", "binary-varint", "binary-zstd"};
+        if (std::find(choices.begin(), choices.end(), value) == choices.end()) {
+            throw std::invalid_argument("--output-format can only take in text, binary, binary-varint, or binary-zstd.");
+        }
+        if (value == "binary-zstd" && !MembershipIO::HasZstd()) {
+            throw std::invalid_argument("--output-format binary-zstd needs a build with zstd.");
+        }
+        return value;
+    };
+    auto prune_action = [](const std::string& value) {
+        if (value != "none" && value != "trees" && value != "paths") {
+            throw std::invalid_argument("--prune can only take in none, trees, or paths.");
+        }
+        return value;
+    };
+    auto worker_backend_action = [](const std::string& value) {
+        if (value != "threads" && value != "processes") {
+            throw std::invalid_argument("--worker-backend can only take in threads or processes.");
+        }
+        return value;
+    };
+    auto memory_size_action = [](const std::string& value) {
+        Consensus::ParseMemorySize(value);
+        return value;
+    };
+    auto pin_threads_action = [](const std::string& value) {
+        if (value != "none" && value != "numa") {
+            throw std::invalid_argument("--pin-threads can only take in none or numa.");
+        }
+        return value;
+    };
+    auto reorder_action = [](const std::string& value) {
+        if (value != "none" && value != "degree" && value != "rcm" && value != "community") {
+            throw std::invalid_argument("--reorder can only take in none, degree, rcm, or community.");
+        }
+        return value;
+    };
+
 
     simple_consensus.add_argument("--edgelist")
         .required()
@@ -35,19 +81,21 @@ int main(int argc, char* argv[]) {
         .scan<'f', double>();
     simple_consensus.add_argument("--partition-file")
         .required()
-        .help("Clustering partition file where the first column is one of (leiden-cpm, leiden-mod, louvain), second column is its weight, and the third column is the clustering method parameter (resolution value for leiden-cpm, ignored for leiden-mod and louvain. One can put -1 here in these cases).");
+        .help("Clustering partition file where the first column is one of (leiden-cpm, leiden-mod, louvain, parallel-leiden-cpm, parallel-leiden-mod, lpa, any of them optionally followed by -cm), second column is its weight, and the third column is the clustering method parameter (resolution value for leiden-cpm and parallel-leiden-cpm, ignored for leiden-mod, parallel-leiden-mod, lpa and louvain. One can put -1 here in these cases).");
     simple_consensus.add_argument("--final-algorithm")
-        .help("Final clustering algorithm to be used (leiden-cpm, leiden-mod, louvain)")
+        .help("Final clustering algorithm to be used (leiden-cpm, leiden-mod, louvain, parallel-leiden-cpm, parallel-leiden-mod). Appending -cm runs the connectivity modifier on the result")
         .action([](const std::string& value) {
-            static const std::vector<std::string> choices = {"leiden-cpm", "leiden-mod", "louvain"};
-            if (std::find(choices.begin(), choices.end(), value) != choices.end()) {
+            static const std::vector<std::string> choices = {"leiden-cpm", "leiden-mod", "louvain", "parallel-leiden-cpm", "parallel-leiden-mod"};
+            bool cm_flag = value.size() > 3 && value.compare(value.size() - 3, 3, "-cm") == 0;
+            std::string base_algorithm = cm_flag ? value.substr(0, value.size() - 3) : value;
+            if (std::find(choices.begin(), choices.end(), base_algorithm) != choices.end()) {
                 return value;
             }
-            throw std::invalid_argument("--algorithm can only take in leiden-cpm, leiden-mod, or louvain.");
+            throw std::invalid_argument("--algorithm can only take in leiden-cpm, leiden-mod, louvain, parallel-leiden-cpm, or parallel-leiden-mod, optionally followed by -cm.");
         });
     simple_consensus.add_argument("--final-resolution")
         .default_value(double(0.01))
-        .help("Resolution value for the final run. Only used if --final-algorithm is leiden-cpm")
+        .help("Resolution value for the final run. Only used if --final-algorithm is leiden-cpm or parallel-leiden-cpm")
         .scan<'f', double>();
     simple_consensus.add_argument("--delta")
         .default_value(double(0.02))
@@ -75,6 +123,40 @@ int main(int argc, char* argv[]) {
         .default_value(int(1))
         .help("Log level where 0 = silent, 1 = info, 2 = verbose")
         .scan<'d', int>();
+    simple_consensus.add_argument("--worker-backend")
+        .default_value(std::string("threads"))
+        .help("Run the ensemble partitions on threads or on forked processes that share the loaded graph copy-on-write (threads, processes)")
+        .action(worker_backend_action);
+    simple_consensus.add_argument("--max-memory")
+        .default_value(std::string("0"))
+        .help("Memory budget in bytes, optionally followed by K, M, G, or T. Picks the number of concurrent workers that fits (0 = no limit)")
+        .action(memory_size_action);
+    simple_consensus.add_argument("--cache-dir")
+        .default_value(std::string(""))
+        .help("Directory caching every ensemble partition by graph, algorithm, parameter and seed so repeated runs can reuse them");
+    simple_consensus.add_argument("--checkpoint-dir")
+        .default_value(std::string(""))
+        .help("Directory where the state of every finished iteration is checkpointed in the background");
+    simple_consensus.add_argument("--resume")
+        .default_value(false)
+        .implicit_value(true)
+        .help("Continue from the latest valid checkpoint in --checkpoint-dir");
+    simple_consensus.add_argument("--output-format")
+        .default_value(std::string("text"))
+        .help("Output clustering format (text, binary, binary-varint, binary-zstd). Binary outputs can be read back as clustering files")
+        .action(output_format_action);
+    simple_consensus.add_argument("--relabel-by-size")
+        .default_value(false)
+        .implicit_value(true)
+        .help("Renumber the output clusters 0, 1, ... from the largest to the smallest");
+    simple_consensus.add_argument("--reorder")
+        .default_value(std::string("none"))
+        .help("Relabel the vertices after loading for cache locality (none, degree, rcm, community). Outputs keep the input node ids")
+        .action(reorder_action);
+    simple_consensus.add_argument("--prune")
+        .default_value(std::string("none"))
+        .help("Peel pendant trees (trees) and also paths of degree 2 nodes (paths) before clustering and reattach them to the clusters of their anchors (none, trees, paths)")
+        .action(prune_action);
 
     multi_resolution_consensus.add_argument("--edgelist")
         .required()
@@ -85,7 +167,7 @@ int main(int argc, char* argv[]) {
         .scan<'f', double>();
     multi_resolution_consensus.add_argument("--partition-file")
         .required()
-        .help("Clustering partition file where the first column is one of (leiden-cpm, leiden-mod, louvain), second column is its weight, and the third column is the clustering method parameter (resolution value for leiden-cpm, ignored for leiden-mod and louvain. One can put -1 here in these cases).");
+        .help("Clustering partition file where the first column is one of (leiden-cpm, leiden-mod, louvain, parallel-leiden-cpm, parallel-leiden-mod, lpa, any of them optionally followed by -cm), second column is its weight, and the third column is the clustering method parameter (resolution value for leiden-cpm and parallel-leiden-cpm, ignored for leiden-mod, parallel-leiden-mod, lpa and louvain. One can put -1 here in these cases).");
     multi_resolution_consensus.add_argument("--delta")
         .default_value(double(0.02))
         .help("Convergence parameter")
@@ -112,29 +194,69 @@ int main(int argc, char* argv[]) {
         .default_value(int(1))
         .help("Log level where 0 = silent, 1 = info, 2 = verbose")
         .scan<'d', int>();
+    multi_resolution_consensus.add_argument("--worker-backend")
+        .default_value(std::string("threads"))
+        .help("Run the ensemble partitions on threads or on forked processes that share the loaded graph copy-on-write (threads, processes)")
+        .action(worker_backend_action);
+    multi_resolution_consensus.add_argument("--max-memory")
+        .default_value(std::string("0"))
+        .help("Memory budget in bytes, optionally followed by K, M, G, or T. Picks the number of concurrent workers that fits (0 = no limit)")
+        .action(memory_size_action);
+    multi_resolution_consensus.add_argument("--cache-dir")
+        .default_value(std::string(""))
+        .help("Directory caching every ensemble partition by graph, algorithm, parameter and seed so repeated runs can reuse them");
+    multi_resolution_consensus.add_argument("--checkpoint-dir")
+        .default_value(std::string(""))
+        .help("Directory where the state of every finished iteration is checkpointed in the background");
+    multi_resolution_consensus.add_argument("--resume")
+        .default_value(false)
+        .implicit_value(true)
+        .help("Continue from the latest valid checkpoint in --checkpoint-dir");
+    multi_resolution_consensus.add_argument("--output-format")
+        .default_value(std::string("text"))
+        .help("Output clustering format (text, binary, binary-varint, binary-zstd). Binary outputs can be read back as clustering files")
+        .action(output_format_action);
+    multi_resolution_consensus.add_argument("--relabel-by-size")
+        .default_value(false)
+        .implicit_value(true)
+        .help("Renumber the output clusters 0, 1, ... from the largest to the smallest");
+    multi_resolution_consensus.add_argument("--reorder")
+        .default_value(std::string("none"))
+        .help("Relabel the vertices after loading for cache locality (none, degree, rcm, community). Outputs keep the input node ids")
+        .action(reorder_action);
+    multi_resolution_consensus.add_argument("--prune")
+        .default_value(std::string("none"))
+        .help("Peel pendant trees (trees) and also paths of degree 2 nodes (paths) before clustering and reattach them to the clusters of their anchors (none, trees, paths)")
+        .action(prune_action);
+    multi_resolution_consensus.add_argument("--coarsen")
+        .default_value(false)
+        .implicit_value(true)
+        .help("Contract the components of edges every partition agreed on into supernodes before each round of clustering");
 
     threshold_consensus.add_argument("--edgelist")
         .required()
         .help("Network edge-list file");
     threshold_consensus.add_argument("--threshold")
-        .default_value(double(1.0))
-        .help("Threshold value")
-        .scan<'f', double>();
+        .default_value(std::vector<std::string>{"1.0"})
+        .nargs(argparse::nargs_pattern::at_least_one)
+        .help("Threshold value. Several values or start:stop:step ranges reuse one ensemble and write one output clustering per threshold to <output-file>.<threshold>");
     threshold_consensus.add_argument("--partition-file")
         .required()
-        .help("Clustering partition file where the first column is one of (leiden-cpm, leiden-mod, louvain), second column is its weight, and the third column is the clustering method parameter (resolution value for leiden-cpm, ignored for leiden-mod and louvain. One can put -1 here in these cases).");
+        .help("Clustering partition file where the first column is one of (leiden-cpm, leiden-mod, louvain, parallel-leiden-cpm, parallel-leiden-mod, lpa, any of them optionally followed by -cm), second column is its weight, and the third column is the clustering method parameter (resolution value for leiden-cpm and parallel-leiden-cpm, ignored for leiden-mod, parallel-leiden-mod, lpa and louvain. One can put -1 here in these cases).");
     threshold_consensus.add_argument("--final-algorithm")
-        .help("Final clustering algorithm to be used (leiden-cpm, leiden-mod, louvain)")
+        .help("Final clustering algorithm to be used (leiden-cpm, leiden-mod, louvain, parallel-leiden-cpm, parallel-leiden-mod). Appending -cm runs the connectivity modifier on the result. Without it the connected components of the surviving edges are returned")
         .action([](const std::string& value) {
-            static const std::vector<std::string> choices = {"leiden-cpm", "leiden-mod", "louvain"};
-            if (std::find(choices.begin(), choices.end(), value) != choices.end()) {
+            static const std::vector<std::string> choices = {"leiden-cpm", "leiden-mod", "louvain", "parallel-leiden-cpm", "parallel-leiden-mod"};
+            bool cm_flag = value.size() > 3 && value.compare(value.size() - 3, 3, "-cm") == 0;
+            std::string base_algorithm = cm_flag ? value.substr(0, value.size() - 3) : value;
+            if (std::find(choices.begin(), choices.end(), base_algorithm) != choices.end()) {
                 return value;
             }
-            throw std::invalid_argument("--algorithm can only take in leiden-cpm, leiden-mod, or louvain.");
+            throw std::invalid_argument("--algorithm can only take in leiden-cpm, leiden-mod, louvain, parallel-leiden-cpm, or parallel-leiden-mod, optionally followed by -cm.");
         });
     threshold_consensus.add_argument("--final-resolution")
         .default_value(double(0.01))
-        .help("Resolution value for the final run. Only used if --final-algorithm is leiden-cpm")
+        .help("Resolution value for the final run. Only used if --final-algorithm is leiden-cpm or parallel-leiden-cpm")
         .scan<'f', double>();
     threshold_consensus.add_argument("--partitions")
         .default_value(int(10))
@@ -154,6 +276,44 @@ int main(int argc, char* argv[]) {
         .default_value(int(1))
         .help("Log level where 0 = silent, 1 = info, 2 = verbose")
         .scan<'d', int>();
+    threshold_consensus.add_argument("--worker-backend")
+        .default_value(std::string("threads"))
+        .help("Run the ensemble partitions on threads or on forked processes that share the loaded graph copy-on-write (threads, processes)")
+        .action(worker_backend_action);
+    threshold_consensus.add_argument("--cache-dir")
+        .default_value(std::string(""))
+        .help("Directory caching every ensemble partition by graph, algorithm, parameter and seed so repeated runs can reuse them");
+    threshold_consensus.add_argument("--output-format")
+        .default_value(std::string("text"))
+        .help("Output clustering format (text, binary, binary-varint, binary-zstd). Binary outputs can be read back as clustering files")
+        .action(output_format_action);
+    threshold_consensus.add_argument("--relabel-by-size")
+        .default_value(false)
+        .implicit_value(true)
+        .help("Renumber the output clusters 0, 1, ... from the largest to the smallest");
+    threshold_consensus.add_argument("--reorder")
+        .default_value(std::string("none"))
+        .help("Relabel the vertices after loading for cache locality (none, degree, rcm, community). Outputs keep the input node ids")
+        .action(reorder_action);
+    threshold_consensus.add_argument("--prune")
+        .default_value(std::string("none"))
+        .help("Peel pendant trees (trees) and also paths of degree 2 nodes (paths) before clustering and reattach them to the clusters of their anchors (none, trees, paths)")
+        .action(prune_action);
+    threshold_consensus.add_argument("--out-of-core")
+        .default_value(std::string(""))
+        .help("Directory for spill files. The edges, edge weights and ensemble memberships are kept in file-backed mappings there and streamed in chunks, for graphs that do not fit in memory next to the ensemble");
+    threshold_consensus.add_argument("--max-memory")
+        .default_value(std::string("0"))
+        .help("Memory budget in bytes, optionally followed by K, M, G, or T. Picks the number of concurrent workers, whether the ensemble is kept or streamed into the edge weights, and how many edges the out-of-core passes stream at a time (0 = no limit)")
+        .action(memory_size_action);
+    threshold_consensus.add_argument("--huge-pages")
+        .default_value(false)
+        .implicit_value(true)
+        .help("Back the large edge and graph arrays, and in reduce the shard membership rows, with transparent huge pages. Only threshold and reduce place their arrays");
+    threshold_consensus.add_argument("--pin-threads")
+        .default_value(std::string("none"))
+        .help("Pin the OpenMP threads to cores, in contiguous blocks per NUMA node so the arrays they first-touch stay local (none, numa)")
+        .action(pin_threads_action);
 
     simple_ensemble_clustering.add_argument("--edgelist")
         .required()
@@ -170,6 +330,18 @@ int main(int argc, char* argv[]) {
         .nargs(argparse::nargs_pattern::at_least_one)
         .required()
         .help("Input clustering weights");
+    simple_ensemble_clustering.add_argument("--streaming")
+        .default_value(false)
+        .implicit_value(true)
+        .help("Read and fold in one clustering file at a time instead of loading all of them first");
+    simple_ensemble_clustering.add_argument("--output-format")
+        .default_value(std::string("text"))
+        .help("Output clustering format (text, binary, binary-varint, binary-zstd). Binary outputs can be read back as clustering files")
+        .action(output_format_action);
+    simple_ensemble_clustering.add_argument("--relabel-by-size")
+        .default_value(false)
+        .implicit_value(true)
+        .help("Renumber the output clusters 0, 1, ... from the largest to the smallest");
     simple_ensemble_clustering.add_argument("--output-file")
         .required()
         .help("Output clustering file");
@@ -191,7 +363,7 @@ int main(int argc, char* argv[]) {
         .scan<'f', double>();
     ensemble_consensus.add_argument("--partition-file")
         .required()
-        .help("Clustering partition file where the first column is one of (leiden-cpm, leiden-mod, louvain), second column is its weight, and the third column is the clustering method parameter (resolution value for leiden-cpm, ignored for leiden-mod and louvain. One can put -1 here in these cases).");
+        .help("Clustering partition file where the first column is one of (leiden-cpm, leiden-mod, louvain, parallel-leiden-cpm, parallel-leiden-mod, lpa, any of them optionally followed by -cm), second column is its weight, and the third column is the clustering method parameter (resolution value for leiden-cpm and parallel-leiden-cpm, ignored for leiden-mod, parallel-leiden-mod, lpa and louvain. One can put -1 here in these cases).");
     ensemble_consensus.add_argument("--delta")
         .default_value(double(0.02))
         .help("Convergence parameter")
@@ -218,19 +390,59 @@ int main(int argc, char* argv[]) {
         .default_value(int(1))
         .help("Log level where 0 = silent, 1 = info, 2 = verbose")
         .scan<'d', int>();
+    ensemble_consensus.add_argument("--worker-backend")
+        .default_value(std::string("threads"))
+        .help("Run the ensemble partitions on threads or on forked processes that share the loaded graph copy-on-write (threads, processes)")
+        .action(worker_backend_action);
+    ensemble_consensus.add_argument("--max-memory")
+        .default_value(std::string("0"))
+        .help("Memory budget in bytes, optionally followed by K, M, G, or T. Picks the number of concurrent workers and whether voting keeps the cluster to nodes maps or only the cluster sizes (0 = no limit)")
+        .action(memory_size_action);
+    ensemble_consensus.add_argument("--cache-dir")
+        .default_value(std::string(""))
+        .help("Directory caching every ensemble partition by graph, algorithm, parameter and seed so repeated runs can reuse them");
+    ensemble_consensus.add_argument("--checkpoint-dir")
+        .default_value(std::string(""))
+        .help("Directory where the state of every finished iteration is checkpointed in the background");
+    ensemble_consensus.add_argument("--resume")
+        .default_value(false)
+        .implicit_value(true)
+        .help("Continue from the latest valid checkpoint in --checkpoint-dir");
+    ensemble_consensus.add_argument("--output-format")
+        .default_value(std::string("text"))
+        .help("Output clustering format (text, binary, binary-varint, binary-zstd). Binary outputs can be read back as clustering files")
+        .action(output_format_action);
+    ensemble_consensus.add_argument("--relabel-by-size")
+        .default_value(false)
+        .implicit_value(true)
+        .help("Renumber the output clusters 0, 1, ... from the largest to the smallest");
+    ensemble_consensus.add_argument("--reorder")
+        .default_value(std::string("none"))
+        .help("Relabel the vertices after loading for cache locality (none, degree, rcm, community). Outputs keep the input node ids")
+        .action(reorder_action);
+    ensemble_consensus.add_argument("--prune")
+        .default_value(std::string("none"))
+        .help("Peel pendant trees (trees) and also paths of degree 2 nodes (paths) before clustering and reattach them to the clusters of their anchors (none, trees, paths)")
+        .action(prune_action);
+    ensemble_consensus.add_argument("--coarsen")
+        .default_value(false)
+        .implicit_value(true)
+        .help("Contract the components of edges every partition agreed on into supernodes before each round of clustering");
     ensemble_consensus.add_argument("--final-algorithm")
         .default_value("leiden-cpm")
-        .help("Final clustering algorithm to be used (leiden-cpm, leiden-mod, louvain)")
+        .help("Final clustering algorithm to be used (leiden-cpm, leiden-mod, louvain, parallel-leiden-cpm, parallel-leiden-mod). Appending -cm runs the connectivity modifier on the result")
         .action([](const std::string& value) {
-            static const std::vector<std::string> choices = {"leiden-cpm", "leiden-mod", "louvain"};
-            if (std::find(choices.begin(), choices.end(), value) != choices.end()) {
+            static const std::vector<std::string> choices = {"leiden-cpm", "leiden-mod", "louvain", "parallel-leiden-cpm", "parallel-leiden-mod"};
+            bool cm_flag = value.size() > 3 && value.compare(value.size() - 3, 3, "-cm") == 0;
+            std::string base_algorithm = cm_flag ? value.substr(0, value.size() - 3) : value;
+            if (std::find(choices.begin(), choices.end(), base_algorithm) != choices.end()) {
                 return value;
             }
-            throw std::invalid_argument("--algorithm can only take in leiden-cpm, leiden-mod, or louvain.");
+            throw std::invalid_argument("--algorithm can only take in leiden-cpm, leiden-mod, louvain, parallel-leiden-cpm, or parallel-leiden-mod, optionally followed by -cm.");
         });
     ensemble_consensus.add_argument("--final-resolution")
         .default_value(double(0.01))
-        .help("Resolution value for the final run. Only used if --final-algorithm is leiden-cpm")
+        .help("Resolution value for the final run. Only used if --final-algorithm is leiden-cpm or parallel-leiden-cpm")
         .scan<'f', double>();
     ensemble_consensus.add_argument("--voting-flag")
         .default_value(false)
@@ -246,11 +458,126 @@ int main(int argc, char* argv[]) {
         .help("Y for returning the connected components as the final clustering. N for specifying a final clustering algorithm and its parameter settings.");
         
 
+    generate.add_argument("--edgelist")
+        .required()
+        .help("Network edge-list file");
+    generate.add_argument("--partition-file")
+        .required()
+        .help("Clustering partition file where the first column is one of (leiden-cpm, leiden-mod, louvain, parallel-leiden-cpm, parallel-leiden-mod, lpa, any of them optionally followed by -cm), second column is its weight, and the third column is the clustering method parameter (resolution value for leiden-cpm and parallel-leiden-cpm, ignored for leiden-mod, parallel-leiden-mod, lpa and louvain. One can put -1 here in these cases).");
+    generate.add_argument("--partitions")
+        .default_value(int(10))
+        .help("Number of partitions in consensus clustering")
+        .scan<'d', int>();
+    generate.add_argument("--first-partition")
+        .default_value(int(0))
+        .help("First row of the partition file to compute, counting from 0")
+        .scan<'d', int>();
+    generate.add_argument("--last-partition")
+        .default_value(int(-1))
+        .help("Last row of the partition file to compute, inclusive. -1 for the last row")
+        .scan<'d', int>();
+    generate.add_argument("--shard-dir")
+        .required()
+        .help("Directory the partitions are written to as partition.<row>.ccmb");
+    generate.add_argument("--num-processors")
+        .default_value(int(1))
+        .help("Number of processors")
+        .scan<'d', int>();
+    generate.add_argument("--log-file")
+        .required()
+        .help("Output log file");
+    generate.add_argument("--log-level")
+        .default_value(int(1))
+        .help("Log level where 0 = silent, 1 = info, 2 = verbose")
+        .scan<'d', int>();
+    generate.add_argument("--worker-backend")
+        .default_value(std::string("threads"))
+        .help("Run the ensemble partitions on threads or on forked processes that share the loaded graph copy-on-write (threads, processes)")
+        .action(worker_backend_action);
+    generate.add_argument("--cache-dir")
+        .default_value(std::string(""))
+        .help("Directory caching every ensemble partition by graph, algorithm, parameter and seed so repeated runs can reuse them");
+
+    reduce.add_argument("--edgelist")
+        .required()
+        .help("Network edge-list file");
+    reduce.add_argument("--partition-file")
+        .required()
+        .help("The partition file given to generate");
+    reduce.add_argument("--partitions")
+        .default_value(int(10))
+        .help("Number of partitions in consensus clustering")
+        .scan<'d', int>();
+    reduce.add_argument("--shard-dir")
+        .required()
+        .help("Directory holding partition.<row>.ccmb for every row of the partition file");
+    reduce.add_argument("--threshold")
+        .default_value(std::vector<std::string>{"1.0"})
+        .nargs(argparse::nargs_pattern::at_least_one)
+        .help("Threshold value. Several values or start:stop:step ranges write one output clustering per threshold to <output-file>.<threshold>");
+    reduce.add_argument("--final-algorithm")
+        .help("Final clustering algorithm to be used (leiden-cpm, leiden-mod, louvain, parallel-leiden-cpm, parallel-leiden-mod), optionally followed by -cm. Without it the connected components of the surviving edges are returned")
+        .action([](const std::string& value) {
+            static const std::vector<std::string> choices = {"leiden-cpm", "leiden-mod", "louvain", "parallel-leiden-cpm", "parallel-leiden-mod"};
+            bool cm_flag = value.size() > 3 && value.compare(value.size() - 3, 3, "-cm") == 0;
+            std::string base_algorithm = cm_flag ? value.substr(0, value.size() - 3) : value;
+            if (std::find(choices.begin(), choices.end(), base_algorithm) != choices.end()) {
+                return value;
+            }
+            throw std::invalid_argument("--algorithm can only take in leiden-cpm, leiden-mod, louvain, parallel-leiden-cpm, or parallel-leiden-mod, optionally followed by -cm.");
+        });
+    reduce.add_argument("--final-resolution")
+        .default_value(double(0.01))
+        .help("Resolution value for the final run. Only used if --final-algorithm is leiden-cpm or parallel-leiden-cpm")
+        .scan<'f', double>();
+    reduce.add_argument("--num-processors")
+        .default_value(int(1))
+        .help("Number of processors")
+        .scan<'d', int>();
+    reduce.add_argument("--output-file")
+        .required()
+        .help("Output clustering file");
+    reduce.add_argument("--shared-graph")
+        .default_value(std::string(""))
+        .help("Name of a shared memory segment holding the loaded graph. The first reduce job on a node publishes it and later reduce jobs over the same edge-list run on its edges instead of reading the edge-list. Not used with --out-of-core");
+    reduce.add_argument("--log-file")
+        .required()
+        .help("Output log file");
+    reduce.add_argument("--log-level")
+        .default_value(int(1))
+        .help("Log level where 0 = silent, 1 = info, 2 = verbose")
+        .scan<'d', int>();
+    reduce.add_argument("--output-format")
+        .default_value(std::string("text"))
+        .help("Output clustering format (text, binary, binary-varint, binary-zstd). Binary outputs can be read back as clustering files")
+        .action(output_format_action);
+    reduce.add_argument("--relabel-by-size")
+        .default_value(false)
+        .implicit_value(true)
+        .help("Renumber the output clusters 0, 1, ... from the largest to the smallest");
+    reduce.add_argument("--out-of-core")
+        .default_value(std::string(""))
+        .help("Directory for spill files. The edges, edge weights and ensemble memberships are kept in file-backed mappings there and streamed in chunks, for graphs that do not fit in memory next to the ensemble");
+    reduce.add_argument("--max-memory")
+        .default_value(std::string("0"))
+        .help("Memory budget in bytes, optionally followed by K, M, G, or T. Picks the number of concurrent workers, whether the ensemble is kept or streamed into the edge weights, and how many edges the out-of-core passes stream at a time (0 = no limit)")
+        .action(memory_size_action);
+    reduce.add_argument("--huge-pages")
+        .default_value(false)
+        .implicit_value(true)
+        .help("Back the large edge and graph arrays, and in reduce the shard membership rows, with transparent huge pages. Only threshold and reduce place their arrays");
+    reduce.add_argument("--pin-threads")
+        .default_value(std::string("none"))
+        .help("Pin the OpenMP threads to cores, in contiguous blocks per NUMA node so the arrays they first-touch stay local (none, numa)")
+        .action(pin_threads_action);
+
     main_program.add_subparser(simple_consensus);
     main_program.add_subparser(multi_resolution_consensus);
     main_program.add_subparser(threshold_consensus);
     main_program.add_subparser(simple_ensemble_clustering);
     main_program.add_subparser(ensemble_consensus);
+    main_program.add_subparser(generate);
+    main_program.add_subparser(reduce);
 
     try {
         main_program.parse_args(argc, argv);
@@ -274,8 +601,18 @@ int main(int argc, char* argv[]) {
         std::string log_file = simple_consensus.get<std::string>("--log-file");
         int log_level = simple_consensus.get<int>("--log-level");
         Consensus* sc = new SimpleConsensus(edgelist, partition_file, final_algorithm, threshold, final_resolution, delta, max_iter, num_partitions, num_processors, output_file, log_file, log_level);
-        sc->main();
+        sc->SetCacheDirectory(simple_consensus.get<std::string>("--cache-dir"));
+        sc->SetWorkerBackend(simple_consensus.get<std::string>("--worker-backend"));
+        sc->SetMaxMemory(Consensus::ParseMemorySize(simple_consensus.get<std::string>("--max-memory")));
+        sc->SetCheckpointDirectory(simple_consensus.get<std::string>("--checkpoint-dir"));
+        sc->SetResume(simple_consensus.get<bool>("--resume"));
+        sc->SetOutputFormat(simple_consensus.get<std::string>("--output-format"));
+        sc->SetRelabelBySize(simple_consensus.get<bool>("--relabel-by-size"));
+        sc->SetPruneMode(simple_consensus.get<std::string>("--prune"));
+        sc->SetReorderMode(simple_consensus.get<std::string>("--reorder"));
+        int exit_code = sc->main();
         delete sc;
+        return exit_code;
     } else if(main_program.is_subcommand_used(multi_resolution_consensus)) {
         std::string edgelist = multi_resolution_consensus.get<std::string>("--edgelist");
         std::string partition_file = multi_resolution_consensus.get<std::string>("--partition-file");
@@ -288,22 +625,43 @@ int main(int argc, char* argv[]) {
         std::string log_file = multi_resolution_consensus.get<std::string>("--log-file");
         int log_level = multi_resolution_consensus.get<int>("--log-level");
         Consensus* mrc = new MultiResolutionConsensus(edgelist, partition_file, threshold, delta, max_iter, num_partitions, num_processors, output_file, log_file, log_level);
-        mrc->main();
+        mrc->SetCacheDirectory(multi_resolution_consensus.get<std::string>("--cache-dir"));
+        mrc->SetWorkerBackend(multi_resolution_consensus.get<std::string>("--worker-backend"));
+        mrc->SetMaxMemory(Consensus::ParseMemorySize(multi_resolution_consensus.get<std::string>("--max-memory")));
+        mrc->SetCheckpointDirectory(multi_resolution_consensus.get<std::string>("--checkpoint-dir"));
+        mrc->SetResume(multi_resolution_consensus.get<bool>("--resume"));
+        mrc->SetOutputFormat(multi_resolution_consensus.get<std::string>("--output-format"));
+        mrc->SetRelabelBySize(multi_resolution_consensus.get<bool>("--relabel-by-size"));
+        mrc->SetPruneMode(multi_resolution_consensus.get<std::string>("--prune"));
+        mrc->SetReorderMode(multi_resolution_consensus.get<std::string>("--reorder"));
+        mrc->SetCoarsening(multi_resolution_consensus.get<bool>("--coarsen"));
+        int exit_code = mrc->main();
         delete mrc;
+        return exit_code;
     } else if (main_program.is_subcommand_used(threshold_consensus)) {
         std::string edgelist = threshold_consensus.get<std::string>("--edgelist");
         std::string partition_file = threshold_consensus.get<std::string>("--partition-file");
-        std::string final_algorithm = threshold_consensus.get<std::string>("--final-algorithm");
-        double threshold = threshold_consensus.get<double>("--threshold");
+        std::string final_algorithm = threshold_consensus.present<std::string>("--final-algorithm").value_or("");
+        std::vector<double> thresholds = ThresholdConsensus::ParseThresholds(threshold_consensus.get<std::vector<std::string>>("--threshold"));
         double final_resolution = threshold_consensus.get<double>("--final-resolution");
         int num_partitions = threshold_consensus.get<int>("--partitions");
         int num_processors = threshold_consensus.get<int>("--num-processors");
         std::string output_file = threshold_consensus.get<std::string>("--output-file");
         std::string log_file = threshold_consensus.get<std::string>("--log-file");
         int log_level = threshold_consensus.get<int>("--log-level");
-        Consensus* tc = new ThresholdConsensus(edgelist, partition_file, final_algorithm, threshold, final_resolution, num_partitions, num_processors, output_file, log_file, log_level);
-        tc->main();
+        Consensus* tc = new ThresholdConsensus(edgelist, partition_file, final_algorithm, thresholds, final_resolution, num_partitions, num_processors, output_file, log_file, log_level);
+        tc->SetCacheDirectory(threshold_consensus.get<std::string>("--cache-dir"));
+        tc->SetWorkerBackend(threshold_consensus.get<std::string>("--worker-backend"));
+        tc->SetOutputFormat(threshold_consensus.get<std::string>("--output-format"));
+        tc->SetRelabelBySize(threshold_consensus.get<bool>("--relabel-by-size"));
+        tc->SetPruneMode(threshold_consensus.get<std::string>("--prune"));
+        tc->SetReorderMode(threshold_consensus.get<std::string>("--reorder"));
+        tc->SetOutOfCoreDirectory(threshold_consensus.get<std::string>("--out-of-core"));
+        tc->SetMaxMemory(Consensus::ParseMemorySize(threshold_consensus.get<std::string>("--max-memory")));
+        tc->SetMemoryPlacement(threshold_consensus.get<bool>("--huge-pages"), threshold_consensus.get<std::string>("--pin-threads"));
+        int exit_code = tc->main();
         delete tc;
+        return exit_code;
     } else if (main_program.is_subcommand_used(simple_ensemble_clustering)) {
         std::string edgelist = simple_ensemble_clustering.get<std::string>("--edgelist");
         double threshold = simple_ensemble_clustering.get<double>("--threshold");
@@ -312,9 +670,13 @@ int main(int argc, char* argv[]) {
         std::string output_file = simple_ensemble_clustering.get<std::string>("--output-file");
         std::string log_file = simple_ensemble_clustering.get<std::string>("--log-file");
         int log_level = simple_ensemble_clustering.get<int>("--log-level");
-        Consensus* sc = new SimpleEnsembleClustering(edgelist, threshold, clustering_files, clustering_weights, output_file, log_file, log_level);
-        sc->main();
+        bool streaming = simple_ensemble_clustering.get<bool>("--streaming");
+        Consensus* sc = new SimpleEnsembleClustering(edgelist, threshold, clustering_files, clustering_weights, output_file, log_file, log_level, streaming);
+        sc->SetOutputFormat(simple_ensemble_clustering.get<std::string>("--output-format"));
+        sc->SetRelabelBySize(simple_ensemble_clustering.get<bool>("--relabel-by-size"));
+        int exit_code = sc->main();
         delete sc;
+        return exit_code;
     } else if(main_program.is_subcommand_used(ensemble_consensus)) {
         std::string edgelist = ensemble_consensus.get<std::string>("--edgelist");
         std::string partition_file = ensemble_consensus.get<std::string>("--partition-file");
@@ -332,7 +694,56 @@ int main(int argc, char* argv[]) {
         bool delta_convergence_flag = ensemble_consensus.get<bool>("--delta-convergence-flag");
         bool final_clustering_flag = ensemble_consensus.get<bool>("--final-clustering-flag");
         Consensus* ec = new EnsembleConsensus(edgelist, partition_file, final_algorithm, threshold, final_resolution, delta, max_iter, num_partitions, num_processors, output_file, log_file, log_level, voting_flag, delta_convergence_flag, final_clustering_flag) ;
-        ec->main();
+        ec->SetCacheDirectory(ensemble_consensus.get<std::string>("--cache-dir"));
+        ec->SetWorkerBackend(ensemble_consensus.get<std::string>("--worker-backend"));
+        ec->SetMaxMemory(Consensus::ParseMemorySize(ensemble_consensus.get<std::string>("--max-memory")));
+        ec->SetCheckpointDirectory(ensemble_consensus.get<std::string>("--checkpoint-dir"));
+        ec->SetResume(ensemble_consensus.get<bool>("--resume"));
+        ec->SetOutputFormat(ensemble_consensus.get<std::string>("--output-format"));
+        ec->SetRelabelBySize(ensemble_consensus.get<bool>("--relabel-by-size"));
+        ec->SetPruneMode(ensemble_consensus.get<std::string>("--prune"));
+        ec->SetReorderMode(ensemble_consensus.get<std::string>("--reorder"));
+        ec->SetCoarsening(ensemble_consensus.get<bool>("--coarsen"));
+        int exit_code = ec->main();
         delete ec;
+        return exit_code;
+    } else if(main_program.is_subcommand_used(generate)) {
+        std::string edgelist = generate.get<std::string>("--edgelist");
+        std::string partition_file = generate.get<std::string>("--partition-file");
+        int num_partitions = generate.get<int>("--partitions");
+        int first_partition = generate.get<int>("--first-partition");
+        int last_partition = generate.get<int>("--last-partition");
+        std::string shard_directory = generate.get<std::string>("--shard-dir");
+        int num_processors = generate.get<int>("--num-processors");
+        std::string log_file = generate.get<std::string>("--log-file");
+        int log_level = generate.get<int>("--log-level");
+        Consensus* eg = new EnsembleGenerator(edgelist, partition_file, first_partition, last_partition, num_partitions, num_processors, shard_directory, log_file, log_level);
+        eg->SetCacheDirectory(generate.get<std::string>("--cache-dir"));
+        eg->SetWorkerBackend(generate.get<std::string>("--worker-backend"));
+        int exit_code = eg->main();
+        delete eg;
+        return exit_code;
+    } else if(main_program.is_subcommand_used(reduce)) {
+        std::string edgelist = reduce.get<std::string>("--edgelist");
+        std::string partition_file = reduce.get<std::string>("--partition-file");
+        std::string final_algorithm = reduce.present<std::string>("--final-algorithm").value_or("");
+        std::vector<double> thresholds = ThresholdConsensus::ParseThresholds(reduce.get<std::vector<std::string>>("--threshold"));
+        double final_resolution = reduce.get<double>("--final-resolution");
+        int num_partitions = reduce.get<int>("--partitions");
+        int num_processors = reduce.get<int>("--num-processors");
+        std::string output_file = reduce.get<std::string>("--output-file");
+        std::string log_file = reduce.get<std::string>("--log-file");
+        int log_level = reduce.get<int>("--log-level");
+        ThresholdConsensus* tc = new ThresholdConsensus(edgelist, partition_file, final_algorithm, thresholds, final_resolution, num_partitions, num_processors, output_file, log_file, log_level);
+        tc->SetShardDirectory(reduce.get<std::string>("--shard-dir"));
+        tc->SetSharedGraph(reduce.get<std::string>("--shared-graph"));
+        tc->SetOutputFormat(reduce.get<std::string>("--output-format"));
+        tc->SetRelabelBySize(reduce.get<bool>("--relabel-by-size"));
+        tc->SetOutOfCoreDirectory(reduce.get<std::string>("--out-of-core"));
+        tc->SetMaxMemory(Consensus::ParseMemorySize(reduce.get<std::string>("--max-memory")));
+        tc->SetMemoryPlacement(reduce.get<bool>("--huge-pages"), reduce.get<std::string>("--pin-threads"));
+        int exit_code = tc->main();
+        delete tc;
+        return exit_code;
     }
 }
@@ -0,0 +1,193 @@
+#include "membership_io.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <omp.h>
+#ifdef CONSENSUS_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "memory_placement.h"
+
+namespace {
+    struct BinaryMembershipHeader {
+        char magic[4];
+        uint32_t version;
+        uint32_t flags;
+        uint32_t reserved;
+        uint64_t num_nodes;
+        uint64_t id_map;
+        uint64_t payload_size;
+    };
+
+    const size_t varint_block_size = 1 << 20;
+
+    // blocks are encoded in parallel and concatenated in order
+    std::vector<char> EncodeVarints(const std::vector<uint32_t>& labels) {
+        size_t num_blocks = (labels.size() + varint_block_size - 1) / varint_block_size;
+        std::vector<std::vector<char>> block_payloads(num_blocks);
+        #pragma omp parallel for schedule(static)
+        for(size_t block = 0; block < num_blocks; block ++) {
+            size_t block_end = std::min(labels.size(), (block + 1) * varint_block_size);
+            std::vector<char>& block_payload = block_payloads[block];
+            block_payload.reserve((block_end - block * varint_block_size) * 2);
+            for(size_t i = block * varint_block_size; i < block_end; i ++) {
+                uint32_t value = labels[i] + 1;
+                while(value >= 0x80) {
+                    block_payload.push_back(static_cast<char>((value & 0x7f) | 0x80));
+                    value >>= 7;
+                }
+                block_payload.push_back(static_cast<char>(value));
+            }
+        }
+        std::vector<char> payload;
+        for(auto const& block_payload : block_payloads) {
+            payload.insert(payload.end(), block_payload.begin(), block_payload.end());
+        }
+        return payload;
+    }
+
+    bool DecodeVarints(const std::vector<char>& payload, uint32_t* labels, size_t num_labels) {
+        size_t position = 0;
+        for(size_t i = 0; i < num_labels; i ++) {
+            uint32_t value = 0;
+            int shift = 0;
+            while(true) {
+                if(position >= payload.size() || shift > 28) {
+                    return false;
+                }
+                uint8_t byte = static_cast<uint8_t>(payload[position ++]);
+                value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+                if(byte < 0x80) {
+                    break;
+                }
+                shift += 7;
+            }
+            labels[i] = value - 1;
+        }
+        return position == payload.size();
+    }
+}
+
+bool MembershipIO::WriteBinaryMembership(std::string membership_file, const std::vector<uint32_t>& labels, uint32_t flags, uint64_t id_map) {
+#ifndef CONSENSUS_HAVE_ZSTD
+    if(flags & MembershipIO::zstd_flag) {
+        return false;
+    }
+#endif
+    std::vector<char> payload;
+    if(flags & MembershipIO::varint_flag) {
+        payload = EncodeVarints(labels);
+    }
+#ifdef CONSENSUS_HAVE_ZSTD
+    if(flags & MembershipIO::zstd_flag) {
+        const char* source = (flags & MembershipIO::varint_flag) ? payload.data() : reinterpret_cast<const char*>(labels.data());
+        size_t source_size = (flags & MembershipIO::varint_flag) ? payload.size() : labels.size() * sizeof(uint32_t);
+        std::vector<char> compressed_payload(ZSTD_compressBound(source_size));
+        size_t compressed_size = ZSTD_compress(compressed_payload.data(), compressed_payload.size(), source, source_size, 3);
+        if(ZSTD_isError(compressed_size)) {
+            return false;
+        }
+        compressed_payload.resize(compressed_size);
+        payload.swap(compressed_payload);
+    }
+#endif
+    bool raw_labels = flags == 0;
+    uint64_t payload_size = raw_labels ? labels.size() * sizeof(uint32_t) : payload.size();
+
+    FILE* membership_file_handle = fopen(membership_file.c_str(), "wb");
+    if(membership_file_handle == nullptr) {
+        return false;
+    }
+    BinaryMembershipHeader header = {{'C', 'C', 'M', 'B'}, MembershipIO::version, flags, 0, labels.size(), id_map, payload_size};
+    bool success = fwrite(&header, sizeof(header), 1, membership_file_handle) == 1;
+    if(raw_labels) {
+        success = success && fwrite(labels.data(), sizeof(uint32_t), labels.size(), membership_file_handle) == labels.size();
+    } else {
+        success = success && fwrite(payload.data(), 1, payload.size(), membership_file_handle) == payload.size();
+    }
+    success = (fclose(membership_file_handle) == 0) && success;
+    return success;
+}
+
+template<typename LabelVector>
+bool MembershipIO::ReadBinaryMembership(std::string membership_file, LabelVector& labels, uint64_t* id_map) {
+    FILE* membership_file_handle = fopen(membership_file.c_str(), "rb");
+    if(membership_file_handle == nullptr) {
+        return false;
+    }
+    BinaryMembershipHeader header;
+    bool success = fread(&header, sizeof(header), 1, membership_file_handle) == 1
+        && std::memcmp(header.magic, "CCMB", 4) == 0
+        && header.version == MembershipIO::version;
+#ifndef CONSENSUS_HAVE_ZSTD
+    success = success && !(header.flags & MembershipIO::zstd_flag);
+#endif
+    // the sizes are checked against the file before anything is allocated from them, so a truncated or corrupt
+    // header is rejected instead of asking for an arbitrary amount of memory
+    std::error_code size_error;
+    uint64_t file_size = std::filesystem::file_size(membership_file, size_error);
+    success = success && !size_error && header.payload_size == file_size - sizeof(header)
+        && header.num_nodes <= MembershipIO::max_num_nodes;
+    if(success && !(header.flags & MembershipIO::zstd_flag)) {
+        // packed labels take 4 bytes each and varint labels at least 1
+        success = (header.flags & MembershipIO::varint_flag) ? header.num_nodes <= header.payload_size : header.num_nodes * sizeof(uint32_t) == header.payload_size;
+    }
+    if(success && header.flags == 0) {
+        labels.resize(header.num_nodes);
+        success = header.payload_size == header.num_nodes * sizeof(uint32_t)
+            && fread(labels.data(), sizeof(uint32_t), header.num_nodes, membership_file_handle) == header.num_nodes;
+    } else if(success) {
+        std::vector<char> payload(header.payload_size);
+        success = fread(payload.data(), 1, payload.size(), membership_file_handle) == payload.size();
+#ifdef CONSENSUS_HAVE_ZSTD
+        if(success && (header.flags & MembershipIO::zstd_flag)) {
+            unsigned long long decompressed_size = ZSTD_getFrameContentSize(payload.data(), payload.size());
+            success = decompressed_size != ZSTD_CONTENTSIZE_ERROR && decompressed_size != ZSTD_CONTENTSIZE_UNKNOWN;
+            // a varint label takes 1 to 5 bytes
+            if(success && (header.flags & MembershipIO::varint_flag)) {
+                success = decompressed_size >= header.num_nodes && decompressed_size <= 5 * header.num_nodes;
+            } else if(success) {
+                success = decompressed_size == header.num_nodes * sizeof(uint32_t);
+            }
+            if(success) {
+                std::vector<char> decompressed_payload(decompressed_size);
+                size_t result = ZSTD_decompress(decompressed_payload.data(), decompressed_payload.size(), payload.data(), payload.size());
+                success = !ZSTD_isError(result) && result == decompressed_size;
+                payload.swap(decompressed_payload);
+            }
+        }
+#endif
+        if(success) {
+            labels.resize(header.num_nodes);
+            if(header.flags & MembershipIO::varint_flag) {
+                success = DecodeVarints(payload, labels.data(), labels.size());
+            } else {
+                success = payload.size() == header.num_nodes * sizeof(uint32_t);
+                if(success) {
+                    std::memcpy(labels.data(), payload.data(), payload.size());
+                }
+            }
+        }
+    }
+    fclose(membership_file_handle);
+    if(success && id_map != nullptr) {
+        *id_map = header.id_map;
+    }
+    return success;
+}
+
+template bool MembershipIO::ReadBinaryMembership(std::string membership_file, std::vector<uint32_t>& labels, uint64_t* id_map);
+template bool MembershipIO::ReadBinaryMembership(std::string membership_file, PlacedVector<uint32_t>& labels, uint64_t* id_map);
+
+bool MembershipIO::IsBinaryMembershipFile(std::string membership_file) {
+    FILE* membership_file_handle = fopen(membership_file.c_str(), "rb");
+    if(membership_file_handle == nullptr) {
+        return false;
+    }
+    char magic[4];
+    bool is_binary = fread(magic, 1, 4, membership_file_handle) == 4 && std::memcmp(magic, "CCMB", 4) == 0;
+    fclose(membership_file_handle);
+    return is_binary;
+}
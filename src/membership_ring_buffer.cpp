@@ -0,0 +1,65 @@
+#include "membership_ring_buffer.h"
+
+#include <algorithm>
+#include <new>
+#include <stdexcept>
+#include <sched.h>
+#include <sys/mman.h>
+
+#include "membership_io.h"
+
+MembershipRingBuffer::MembershipRingBuffer(int num_slots, int64_t num_nodes, int first_partition) : num_slots(num_slots), num_nodes(num_nodes) {
+    // slots start on cache lines so the sequence numbers of neighbouring slots do not share one
+    const size_t cache_line_size = 64;
+    this->slot_size = (sizeof(SlotHeader) + num_nodes * sizeof(uint32_t) + cache_line_size - 1) / cache_line_size * cache_line_size;
+    size_t header_size = (sizeof(Header) + cache_line_size - 1) / cache_line_size * cache_line_size;
+    this->mapping_size = header_size + this->num_slots * this->slot_size;
+    this->mapping = mmap(NULL, this->mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if(this->mapping == MAP_FAILED) {
+        throw std::runtime_error("could not map the shared membership ring buffer");
+    }
+    this->header = new(this->mapping) Header();
+    this->header->enqueue_position.store(0, std::memory_order_relaxed);
+    this->header->next_partition.store(first_partition, std::memory_order_relaxed);
+    this->header->num_cache_hits.store(0, std::memory_order_relaxed);
+    this->header->dequeue_position = 0;
+    this->slots = static_cast<char*>(this->mapping) + header_size;
+    for(int slot = 0; slot < this->num_slots; slot ++) {
+        SlotHeader* slot_header = new(this->slots + slot * this->slot_size) SlotHeader();
+        slot_header->sequence.store(slot, std::memory_order_relaxed);
+    }
+}
+
+MembershipRingBuffer::~MembershipRingBuffer() {
+    munmap(this->mapping, this->mapping_size);
+}
+
+void MembershipRingBuffer::Push(int partition_index, const std::map<int, int>& partition_map) {
+    uint64_t position = this->header->enqueue_position.fetch_add(1, std::memory_order_relaxed);
+    SlotHeader* slot = this->GetSlot(position);
+    // the slot is free once the consumer has moved its sequence one lap ahead
+    while(slot->sequence.load(std::memory_order_acquire) != position) {
+        sched_yield();
+    }
+    uint32_t* labels = this->GetSlotLabels(slot);
+    std::fill(labels, labels + this->num_nodes, MembershipIO::no_membership);
+    for(auto const& [node_id, cluster_id] : partition_map) {
+        labels[node_id] = cluster_id;
+    }
+    slot->partition_index = partition_index;
+    slot->sequence.store(position + 1, std::memory_order_release);
+}
+
+bool MembershipRingBuffer::TryPop(int& partition_index, std::vector<uint32_t>& labels) {
+    uint64_t position = this->header->dequeue_position;
+    SlotHeader* slot = this->GetSlot(position);
+    if(slot->sequence.load(std::memory_order_acquire) != position + 1) {
+        return false;
+    }
+    partition_index = slot->partition_index;
+    uint32_t* slot_labels = this->GetSlotLabels(slot);
+    labels.assign(slot_labels, slot_labels + this->num_nodes);
+    slot->sequence.store(position + this->num_slots, std::memory_order_release);
+    this->header->dequeue_position = position + 1;
+    return true;
+}
@@ -0,0 +1,133 @@
+#include "memory_placement.h"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <omp.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static size_t GetMappingBytes(size_t num_bytes) {
+    return (num_bytes + MemoryPlacement::huge_page_bytes - 1) / MemoryPlacement::huge_page_bytes * MemoryPlacement::huge_page_bytes;
+}
+
+void* MemoryPlacement::Allocate(size_t num_bytes) {
+    // map one huge page more than needed and trim both ends so the array starts on a huge page boundary
+    size_t mapping_bytes = GetMappingBytes(num_bytes);
+    void* mapping = mmap(nullptr, mapping_bytes + MemoryPlacement::huge_page_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(mapping == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    uintptr_t mapping_begin = reinterpret_cast<uintptr_t>(mapping);
+    uintptr_t aligned_begin = (mapping_begin + MemoryPlacement::huge_page_bytes - 1) / MemoryPlacement::huge_page_bytes * MemoryPlacement::huge_page_bytes;
+    if(aligned_begin > mapping_begin) {
+        munmap(mapping, aligned_begin - mapping_begin);
+    }
+    size_t tail_bytes = mapping_begin + MemoryPlacement::huge_page_bytes - aligned_begin;
+    if(tail_bytes > 0) {
+        munmap(reinterpret_cast<void*>(aligned_begin + mapping_bytes), tail_bytes);
+    }
+    char* data = reinterpret_cast<char*>(aligned_begin);
+#ifdef MADV_HUGEPAGE
+    if(MemoryPlacement::huge_pages_flag) {
+        madvise(data, mapping_bytes, MADV_HUGEPAGE);
+    }
+#endif
+
+    // the kernel places a page on the node of the thread that first writes it, so the team writes the pages in
+    // the same static chunks the kernels later read them in. every base page is written in case no huge page is granted
+    int64_t touch_bytes = sysconf(_SC_PAGESIZE);
+    int64_t num_pages = (mapping_bytes + touch_bytes - 1) / touch_bytes;
+    #pragma omp parallel for schedule(static)
+    for(int64_t page = 0; page < num_pages; page ++) {
+        data[page * touch_bytes] = 0;
+    }
+    return data;
+}
+
+void MemoryPlacement::Deallocate(void* pointer, size_t num_bytes) {
+    munmap(pointer, GetMappingBytes(num_bytes));
+}
+
+std::vector<std::vector<int>> MemoryPlacement::GetNodeCpus() {
+    // the cpus this process may run on grouped by NUMA node, one group when sysfs has no node information
+    cpu_set_t allowed_cpus;
+    CPU_ZERO(&allowed_cpus);
+    sched_getaffinity(0, sizeof(allowed_cpus), &allowed_cpus);
+    std::vector<std::vector<int>> node_cpus;
+    std::error_code error_code;
+    std::vector<std::filesystem::path> node_directories;
+    for(auto const& entry : std::filesystem::directory_iterator("/sys/devices/system/node", error_code)) {
+        std::string name = entry.path().filename().string();
+        if(name.rfind("node", 0) == 0 && name.size() > 4 && std::all_of(name.begin() + 4, name.end(), ::isdigit)) {
+            node_directories.push_back(entry.path());
+        }
+    }
+    std::sort(node_directories.begin(), node_directories.end(), [](const std::filesystem::path& lhs, const std::filesystem::path& rhs) {
+        return std::stoi(lhs.filename().string().substr(4)) < std::stoi(rhs.filename().string().substr(4));
+    });
+    for(auto const& node_directory : node_directories) {
+        // cpulist looks like 0-3,8-11
+        std::ifstream cpulist_file(node_directory / "cpulist");
+        std::string cpu_range;
+        std::vector<int> cpus;
+        while(std::getline(cpulist_file, cpu_range, ',')) {
+            size_t dash_position = cpu_range.find('-');
+            int first_cpu = std::stoi(cpu_range.substr(0, dash_position));
+            int last_cpu = (dash_position == std::string::npos) ? first_cpu : std::stoi(cpu_range.substr(dash_position + 1));
+            for(int cpu = first_cpu; cpu <= last_cpu; cpu ++) {
+                if(cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed_cpus)) {
+                    cpus.push_back(cpu);
+                }
+            }
+        }
+        if(!cpus.empty()) {
+            node_cpus.push_back(cpus);
+        }
+    }
+    if(node_cpus.empty()) {
+        node_cpus.push_back({});
+        for(int cpu = 0; cpu < CPU_SETSIZE; cpu ++) {
+            if(CPU_ISSET(cpu, &allowed_cpus)) {
+                node_cpus.back().push_back(cpu);
+            }
+        }
+    }
+    return node_cpus;
+}
+
+int MemoryPlacement::PinThreads(int num_threads) {
+    // thread t goes to node t * nodes / threads so every node runs a contiguous block of the static chunks
+    std::vector<std::vector<int>> node_cpus = MemoryPlacement::GetNodeCpus();
+    int num_nodes = std::min<int>(node_cpus.size(), num_threads);
+    sched_getaffinity(0, sizeof(MemoryPlacement::unpinned_cpus), &MemoryPlacement::unpinned_cpus);
+    #pragma omp parallel num_threads(num_threads)
+    {
+        int thread_id = omp_get_thread_num();
+        int node = static_cast<int64_t>(thread_id) * num_nodes / num_threads;
+        int first_thread_of_node = (static_cast<int64_t>(node) * num_threads + num_nodes - 1) / num_nodes;
+        const std::vector<int>& cpus = node_cpus[node];
+        cpu_set_t thread_cpus;
+        CPU_ZERO(&thread_cpus);
+        if(thread_id == 0) {
+            // the main thread spawns the worker threads, which would inherit a single core
+            for(int cpu : cpus) {
+                CPU_SET(cpu, &thread_cpus);
+            }
+        } else {
+            CPU_SET(cpus[(thread_id - first_thread_of_node) % cpus.size()], &thread_cpus);
+        }
+        sched_setaffinity(0, sizeof(thread_cpus), &thread_cpus);
+    }
+    MemoryPlacement::pinned_flag = true;
+    return num_nodes;
+}
+
+void MemoryPlacement::UnpinThisThread() {
+    // ensemble workers and forked children share the processors among themselves and are left to the scheduler
+    if(MemoryPlacement::pinned_flag) {
+        sched_setaffinity(0, sizeof(MemoryPlacement::unpinned_cpus), &MemoryPlacement::unpinned_cpus);
+    }
+}
@@ -0,0 +1,106 @@
+#include "memory_planner.h"
+#include "edge_weight.h"
+
+#include <algorithm>
+#include <sys/resource.h>
+
+std::string MemoryPlan::Describe() const {
+    std::string description = std::to_string(this->num_workers) + " concurrent workers, ";
+    description += this->materialised_memberships ? "materialised memberships" : "streaming accumulation";
+    if(this->voting) {
+        description += this->voting_maps ? ", voting on cluster to nodes maps" : ", voting on cluster sizes";
+    }
+    return description;
+}
+
+int64_t MemoryPlanner::GetGraphBytes() const {
+    // igraph keeps from, to and both edge indices per edge, two node index vectors and the weight attribute
+    return this->num_edges * (4 * sizeof(int64_t) + sizeof(double)) + 2 * (this->num_nodes + 1) * sizeof(int64_t);
+}
+
+int64_t MemoryPlanner::GetWorkerBytes(const std::string& algorithm) const {
+    // every worker holds its result as a std::map next to what the algorithm allocates
+    int64_t worker_bytes = this->num_nodes * MemoryPlanner::map_entry_bytes;
+    bool cm_flag = algorithm.size() > 3 && algorithm.compare(algorithm.size() - 3, 3, "-cm") == 0;
+    std::string base_algorithm = cm_flag ? algorithm.substr(0, algorithm.size() - 3) : algorithm;
+    if(base_algorithm == "leiden-cpm" || base_algorithm == "leiden-mod") {
+        // libleidenalg caches the incident edges and weights of every node and a dozen node vectors per level
+        worker_bytes += this->num_edges * (2 * pointer_bytes + sizeof(double)) + this->num_nodes * 16 * sizeof(double);
+    } else if(base_algorithm == "louvain") {
+        // multilevel copies the graph for every level and keeps a membership per level
+        worker_bytes += this->GetGraphBytes() + this->num_nodes * 4 * sizeof(int64_t);
+    } else if(base_algorithm == "parallel-leiden-cpm" || base_algorithm == "parallel-leiden-mod") {
+        // a weighted CSR of the graph and of its first aggregate
+        worker_bytes += 2 * (2 * this->num_edges * (sizeof(int) + sizeof(double)) + (this->num_nodes + 1) * sizeof(int64_t)) + this->num_nodes * 6 * sizeof(double);
+    } else {
+        worker_bytes += 2 * this->num_edges * sizeof(int) + (this->num_nodes + 1) * sizeof(int64_t) + this->num_nodes * 2 * sizeof(int);
+    }
+    if(cm_flag) {
+        // the induced subgraphs of the clusters being cut add up to at most one more copy of the graph
+        worker_bytes += this->GetGraphBytes();
+    }
+    return worker_bytes;
+}
+
+int64_t MemoryPlanner::PredictPeak(const MemoryPlan& plan, bool iterative, bool voting) const {
+    int64_t graph_bytes = (iterative ? 2 : 1) * this->GetGraphBytes();
+    int64_t worker_bytes = 0;
+    for(auto const& algorithm : this->algorithm_vector) {
+        worker_bytes = std::max(worker_bytes, this->GetWorkerBytes(algorithm));
+    }
+    // the finished memberships pile up while the last workers are still running
+    int64_t ensemble_bytes = 0;
+    if(plan.materialised_memberships) {
+        ensemble_bytes = this->num_partitions * this->num_nodes * MemoryPlanner::map_entry_bytes;
+    } else {
+        ensemble_bytes = this->num_edges * sizeof(DisagreementCount);
+    }
+    if(voting) {
+        // a cluster to nodes map has a vector per cluster, the sizes are one int per cluster
+        ensemble_bytes += this->num_partitions * this->num_nodes * (plan.voting_maps ? sizeof(int) + MemoryPlanner::map_entry_bytes : sizeof(int));
+    }
+    int64_t ensemble_phase_bytes = graph_bytes + plan.num_workers * worker_bytes + ensemble_bytes;
+    // the threshold sweep adds an edge list, the counts, the weights, their order and a union-find
+    int64_t accumulation_phase_bytes = graph_bytes + ensemble_bytes;
+    if(!iterative) {
+        accumulation_phase_bytes += this->num_edges * (2 * sizeof(int64_t) + sizeof(DisagreementCount) + sizeof(EdgeWeight) + sizeof(int64_t) + 1) + this->num_nodes * 2 * sizeof(int);
+    }
+    return std::max(ensemble_phase_bytes, accumulation_phase_bytes);
+}
+
+MemoryPlan MemoryPlanner::Plan(int64_t max_memory, bool iterative, bool streaming_possible, bool voting) const {
+    // more workers gain the most, then keeping the memberships and the voting maps, so the first plan that fits wins
+    int max_workers = std::max(1, std::min(this->num_processors, this->num_partitions));
+    MemoryPlan smallest_plan;
+    for(int num_workers = max_workers; num_workers >= 1; num_workers --) {
+        for(bool materialised_memberships : {true, false}) {
+            if(!materialised_memberships && !streaming_possible) {
+                continue;
+            }
+            for(bool voting_maps : {true, false}) {
+                if(!voting_maps && !voting) {
+                    continue;
+                }
+                MemoryPlan plan;
+                plan.num_workers = num_workers;
+                plan.materialised_memberships = materialised_memberships;
+                plan.voting = voting;
+                plan.voting_maps = voting_maps;
+                plan.predicted_peak_bytes = this->PredictPeak(plan, iterative, voting);
+                if(max_memory == 0 || plan.predicted_peak_bytes <= max_memory) {
+                    return plan;
+                }
+                smallest_plan = plan;
+            }
+        }
+    }
+    return smallest_plan;
+}
+
+int64_t MemoryPlanner::GetMeasuredPeakBytes() {
+    // ru_maxrss is in kilobytes on Linux. the workers run next to the main process, so their peaks add to it.
+    // pages the workers share copy-on-write are counted in each of them, which makes this an upper bound
+    struct rusage self_usage;
+    getrusage(RUSAGE_SELF, &self_usage);
+    return self_usage.ru_maxrss * int64_t(1024) + MemoryPlanner::worker_peak_bytes;
+}
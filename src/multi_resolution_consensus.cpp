@@ -6,6 +6,8 @@ bool MultiResolutionConsensus::CheckConvergence(igraph_t* lhs_graph_ptr, igraph_
         // Continuing without checking convergence
         return false;
     }
+    PhaseMetrics::Phase convergence_phase("convergence");
+    convergence_phase.edges_processed = igraph_ecount(lhs_graph_ptr);
     igraph_bool_t is_identical;
     igraph_is_same_graph(lhs_graph_ptr, rhs_graph_ptr, &is_identical);
     if(is_identical) {
@@ -25,20 +27,28 @@ int MultiResolutionConsensus::main() {
     this->WriteToLogFile("Started setting the default edge weights for the initial graph" , 1);
     Consensus::SetIgraphAllEdgesWeight(&graph, 1);
     this->WriteToLogFile("Finished setting the default edge weights for the initial graph" , 1);
+    bool iterative = true;
+    bool streaming_possible = false;
+    this->PlanMemory(&graph, iterative, streaming_possible);
 
     int iter_count = 0;
+    // weights are rounded to the build's edge weight type so settled edges compare equal to max_weight
+    EdgeWeightCodec weight_codec = EdgeWeightCodec::FromPartitionWeights(this->weight_vector);
     double max_weight = 0;
     for (unsigned int i = 0; i < this->weight_vector.size(); i ++) {
-        max_weight += this->weight_vector[i];
+        max_weight = weight_codec.AddWeight(max_weight, this->weight_vector[i]);
     }
 
     igraph_t next_graph;
+    this->ResumeFromCheckpoint(&graph, &next_graph, iter_count);
     while (!MultiResolutionConsensus::CheckConvergence(&graph, &next_graph, iter_count) || iter_count > max_iter) {
         if(iter_count != 0) {
             igraph_destroy(&graph);
             igraph_copy(&graph, &next_graph);
         }
         this->WriteToLogFile("Staring iteration: " + std::to_string(iter_count), 1);
+        ScratchArena::Scope iteration_scope;
+        PhaseMetrics::SetIteration(iter_count);
         this->WriteToLogFile("Starting to copy the intermediate graphs", 1);
         if(iter_count != 0) {
             igraph_destroy(&next_graph);
@@ -49,16 +59,32 @@ int MultiResolutionConsensus::main() {
         Consensus::SetIgraphAllEdgesWeight(&next_graph, 0);
         this->WriteToLogFile("Finsihed setting the edge weight for the intermediate graph", 1);
 
-        std::vector<std::map<int, int>> results;
+        // workers finish in any order, so every result goes to the row of its partition
+        std::vector<std::map<int, int>> results(this->num_partitions);
+        std::unique_ptr<GraphCoarsening> coarsening;
+        if(this->coarsening_flag) {
+            this->WriteToLogFile("Started coarsening the fully agreed edges" , 1);
+            coarsening = std::make_unique<GraphCoarsening>(&graph, max_weight);
+            this->WriteToLogFile("Finished coarsening " + std::to_string(igraph_vcount(&graph)) + " nodes into " + std::to_string(coarsening->NumCoarseNodes()) + " supernodes" , 1);
+        }
         this->WriteToLogFile("Starting workers" , 1);
-        this->StartWorkers(&graph);
+        this->StartWorkers(coarsening ? coarsening->GetCoarseGraph() : &graph);
         while(!Consensus::done_being_clustered_clusterings.empty()) {
-            results.push_back(Consensus::done_being_clustered_clusterings.front());
+            int partition_index = Consensus::done_being_clustered_indices.front();
+            if(coarsening) {
+                results[partition_index] = coarsening->ExpandPartition(Consensus::done_being_clustered_clusterings.front());
+            } else {
+                results[partition_index] = Consensus::done_being_clustered_clusterings.front();
+            }
             Consensus::done_being_clustered_clusterings.pop();
+            Consensus::done_being_clustered_indices.pop();
         }
+        coarsening.reset();
 
         this->WriteToLogFile("Got results back from workers" , 1);
 
+        PhaseMetrics::Phase accumulation_phase("accumulation");
+        accumulation_phase.edges_processed = igraph_ecount(&graph) * this->num_partitions;
         for(int i = 0; i < this->num_partitions; i++) {
             this->WriteToLogFile("Starting to incorate results from worker: " + std::to_string(i) , 1);
             std::map<int, int> current_partition = results.at(i);
@@ -76,7 +102,7 @@ int MultiResolutionConsensus::main() {
                 if(graph_edge_weight != 0 && graph_edge_weight != max_weight) {
                     if(current_partition.at(from_node) == current_partition.at(to_node)) {
                         igraph_real_t next_graph_edge_weight = EAN(&next_graph, "weight", next_graph_current_edge);
-                        next_graph_edge_weight += (1 * (this->weight_vector[i]));
+                        next_graph_edge_weight = weight_codec.AddWeight(next_graph_edge_weight, this->weight_vector[i]);
                         SETEAN(&next_graph, "weight", next_graph_current_edge, next_graph_edge_weight);
                     }
                 } else {
@@ -86,16 +112,27 @@ int MultiResolutionConsensus::main() {
             igraph_eit_destroy(&eit);
             this->WriteToLogFile("Finished incorpating results from worker: " + std::to_string(i) , 1);
         }
+        accumulation_phase.Finish();
         this->WriteToLogFile("Started removing edges from the intermediate graph" , 1);
-        Consensus::RemoveEdgesBasedOnThreshold(&next_graph, this->threshold * max_weight);
+        PhaseMetrics::Phase threshold_phase("threshold");
+        threshold_phase.edges_processed = igraph_ecount(&next_graph);
+        Consensus::RemoveEdgesBasedOnThreshold(&next_graph, weight_codec.FromWeightThreshold(this->threshold, max_weight));
+        threshold_phase.edges_surviving = igraph_ecount(&next_graph);
+        threshold_phase.Finish();
         this->WriteToLogFile("Finished removing edges from the intermediate graph" , 1);
         iter_count ++;
+        this->CheckpointIteration(&graph, &next_graph, iter_count);
     }
+    this->checkpoint_writer.reset();
+    PhaseMetrics::SetIteration(-1);
 
     this->WriteToLogFile("Simple consensus took " + std::to_string(iter_count) + " iterations", 1);
 
     this->WriteToLogFile("Started the final connected components run" , 1);
+    PhaseMetrics::Phase final_clustering_phase("final_clustering");
+    final_clustering_phase.edges_processed = igraph_ecount(&next_graph);
     std::map<int, int> final_partition = Consensus::GetConnectedComponents(&next_graph);
+    final_clustering_phase.Finish();
     this->WriteToLogFile("Finished the final connected components run" , 1);
     
     igraph_destroy(&graph);
@@ -104,9 +141,10 @@ int MultiResolutionConsensus::main() {
     }
 
     this->WriteToLogFile("Started writing to the output clustering file" , 1);
-    this->WritePartitionMap(final_partition);
+    bool write_success = this->WritePartitionMap(final_partition);
     this->WriteToLogFile("Finished writing to the output clustering file" , 1);
+    this->LogMeasuredPeak();
 
 
-    return 0;
+    return write_success ? 0 : 1;
 }
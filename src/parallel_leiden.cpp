@@ -0,0 +1,410 @@
+#include "parallel_leiden.h"
+
+std::vector<int> ParallelLeiden::Run(int num_iter) {
+    std::vector<int> membership(this->graph_ptr->num_nodes);
+    for(int node_id = 0; node_id < this->graph_ptr->num_nodes; node_id ++) {
+        membership[node_id] = node_id;
+    }
+    if(this->graph_ptr->total_strength == 0) {
+        // no edges so every node stays in its own community
+        return membership;
+    }
+    this->round_counter = 0;
+    for(int i = 0; i < num_iter; i ++) {
+        membership = this->RunLevels(membership);
+    }
+    ParallelLeiden::Renumber(membership);
+    return membership;
+}
+
+std::vector<int> ParallelLeiden::RunLevels(const std::vector<int>& initial_membership) {
+    int num_original_nodes = this->graph_ptr->num_nodes;
+    std::vector<int> node_to_current(num_original_nodes);
+    for(int node_id = 0; node_id < num_original_nodes; node_id ++) {
+        node_to_current[node_id] = node_id;
+    }
+    std::vector<int> membership(initial_membership);
+    ParallelLeiden::Renumber(membership);
+
+    CSRGraph coarse_graph;
+    const CSRGraph* current_graph_ptr = this->graph_ptr;
+    while(true) {
+        this->MoveNodes(*current_graph_ptr, membership);
+        std::vector<int> refined_membership = this->RefinePartition(*current_graph_ptr, membership);
+        int num_refined = ParallelLeiden::Renumber(refined_membership);
+        if(num_refined == current_graph_ptr->num_nodes) {
+            // refinement kept every node apart so there is nothing left to aggregate
+            break;
+        }
+
+        // parent communities are fewer than the refined ones so their labels fit the coarse graph
+        ParallelLeiden::Renumber(membership);
+        std::vector<int> coarse_membership(num_refined);
+        #pragma omp parallel for schedule(static)
+        for(int node_id = 0; node_id < current_graph_ptr->num_nodes; node_id ++) {
+            // every member of a refined community shares the same parent community
+            #pragma omp atomic write
+            coarse_membership[refined_membership[node_id]] = membership[node_id];
+        }
+        #pragma omp parallel for schedule(static)
+        for(int node_id = 0; node_id < num_original_nodes; node_id ++) {
+            node_to_current[node_id] = refined_membership[node_to_current[node_id]];
+        }
+
+        CSRGraph next_coarse_graph = this->Aggregate(*current_graph_ptr, refined_membership, num_refined);
+        coarse_graph = std::move(next_coarse_graph);
+        current_graph_ptr = &coarse_graph;
+        membership = std::move(coarse_membership);
+    }
+
+    std::vector<int> original_membership(num_original_nodes);
+    #pragma omp parallel for schedule(static)
+    for(int node_id = 0; node_id < num_original_nodes; node_id ++) {
+        original_membership[node_id] = membership[node_to_current[node_id]];
+    }
+    return original_membership;
+}
+
+bool ParallelLeiden::MoveNodes(const CSRGraph& graph, std::vector<int>& membership) {
+    int num_nodes = graph.num_nodes;
+    std::vector<double> community_sizes(num_nodes, 0);
+    std::vector<double> community_strengths(num_nodes, 0);
+    #pragma omp parallel for schedule(static)
+    for(int node_id = 0; node_id < num_nodes; node_id ++) {
+        #pragma omp atomic
+        community_sizes[membership[node_id]] += graph.node_sizes[node_id];
+        #pragma omp atomic
+        community_strengths[membership[node_id]] += graph.node_strengths[node_id];
+    }
+
+    std::vector<int> proposals(num_nodes);
+    bool changed = false;
+    for(int round = 0; round < ParallelLeiden::max_rounds; round ++) {
+        uint64_t current_round = this->round_counter ++;
+        int64_t num_moved = 0;
+        #pragma omp parallel
+        {
+            std::vector<std::pair<int, double>> neighbor_communities;
+            #pragma omp for schedule(dynamic, 1024) reduction(+:num_moved)
+            for(int node_id = 0; node_id < num_nodes; node_id ++) {
+                int own_community = membership[node_id];
+                proposals[node_id] = own_community;
+                if((HashVertex(this->seed, current_round, node_id) & 1) == 0) {
+                    continue;
+                }
+                neighbor_communities.clear();
+                for(int64_t i = graph.offsets[node_id]; i < graph.offsets[node_id + 1]; i ++) {
+                    int neighbor = graph.neighbors[i];
+                    if(neighbor != node_id) {
+                        neighbor_communities.push_back({membership[neighbor], graph.weights[i]});
+                    }
+                }
+                std::sort(neighbor_communities.begin(), neighbor_communities.end());
+
+                double node_size = graph.node_sizes[node_id];
+                double node_strength = graph.node_strengths[node_id];
+                double edges_to_own = 0;
+                for(auto const& [community, edge_weight] : neighbor_communities) {
+                    if(community == own_community) {
+                        edges_to_own += edge_weight;
+                    }
+                }
+                int best_community = own_community;
+                double best_gain = this->Gain(edges_to_own, node_size, node_strength, community_sizes[own_community] - node_size, community_strengths[own_community] - node_strength, graph.total_strength);
+                for(size_t i = 0; i < neighbor_communities.size(); ) {
+                    int community = neighbor_communities[i].first;
+                    double edges_to_community = 0;
+                    for(; i < neighbor_communities.size() && neighbor_communities[i].first == community; i ++) {
+                        edges_to_community += neighbor_communities[i].second;
+                    }
+                    if(community == own_community) {
+                        continue;
+                    }
+                    double current_gain = this->Gain(edges_to_community, node_size, node_strength, community_sizes[community], community_strengths[community], graph.total_strength);
+                    if(current_gain > best_gain + 1e-12) {
+                        best_gain = current_gain;
+                        best_community = community;
+                    }
+                }
+                if(best_community != own_community) {
+                    proposals[node_id] = best_community;
+                    num_moved ++;
+                }
+            }
+        }
+        if(num_moved == 0) {
+            break;
+        }
+        changed = true;
+        #pragma omp parallel for schedule(static)
+        for(int node_id = 0; node_id < num_nodes; node_id ++) {
+            int old_community = membership[node_id];
+            int new_community = proposals[node_id];
+            if(old_community != new_community) {
+                #pragma omp atomic
+                community_sizes[old_community] -= graph.node_sizes[node_id];
+                #pragma omp atomic
+                community_strengths[old_community] -= graph.node_strengths[node_id];
+                #pragma omp atomic
+                community_sizes[new_community] += graph.node_sizes[node_id];
+                #pragma omp atomic
+                community_strengths[new_community] += graph.node_strengths[node_id];
+                membership[node_id] = new_community;
+            }
+        }
+    }
+    return changed;
+}
+
+std::vector<int> ParallelLeiden::RefinePartition(const CSRGraph& graph, const std::vector<int>& membership) {
+    int num_nodes = graph.num_nodes;
+    std::vector<double> community_sizes(num_nodes, 0);
+    std::vector<double> community_strengths(num_nodes, 0);
+    #pragma omp parallel for schedule(static)
+    for(int node_id = 0; node_id < num_nodes; node_id ++) {
+        #pragma omp atomic
+        community_sizes[membership[node_id]] += graph.node_sizes[node_id];
+        #pragma omp atomic
+        community_strengths[membership[node_id]] += graph.node_strengths[node_id];
+    }
+
+    // only nodes that are well connected to their own community may leave their singleton
+    std::vector<char> well_connected(num_nodes, 0);
+    #pragma omp parallel for schedule(dynamic, 1024)
+    for(int node_id = 0; node_id < num_nodes; node_id ++) {
+        int community = membership[node_id];
+        double edges_inside = 0;
+        for(int64_t i = graph.offsets[node_id]; i < graph.offsets[node_id + 1]; i ++) {
+            int neighbor = graph.neighbors[i];
+            if(neighbor != node_id && membership[neighbor] == community) {
+                edges_inside += graph.weights[i];
+            }
+        }
+        double node_size = graph.node_sizes[node_id];
+        double node_strength = graph.node_strengths[node_id];
+        well_connected[node_id] = this->Gain(edges_inside, node_size, node_strength, community_sizes[community] - node_size, community_strengths[community] - node_strength, graph.total_strength) >= 0;
+    }
+
+    std::vector<int> refined_membership(num_nodes);
+    std::vector<double> refined_sizes(graph.node_sizes);
+    std::vector<double> refined_strengths(graph.node_strengths);
+    std::vector<int> refined_counts(num_nodes, 1);
+    for(int node_id = 0; node_id < num_nodes; node_id ++) {
+        refined_membership[node_id] = node_id;
+    }
+
+    std::vector<double> refined_external(num_nodes);
+    std::vector<int> proposals(num_nodes);
+    std::vector<char> accepted(num_nodes);
+    for(int round = 0; round < ParallelLeiden::max_rounds; round ++) {
+        uint64_t current_round = this->round_counter ++;
+        std::fill(refined_external.begin(), refined_external.end(), 0);
+        #pragma omp parallel for schedule(dynamic, 1024)
+        for(int node_id = 0; node_id < num_nodes; node_id ++) {
+            double edges_out = 0;
+            for(int64_t i = graph.offsets[node_id]; i < graph.offsets[node_id + 1]; i ++) {
+                int neighbor = graph.neighbors[i];
+                if(membership[neighbor] == membership[node_id] && refined_membership[neighbor] != refined_membership[node_id]) {
+                    edges_out += graph.weights[i];
+                }
+            }
+            if(edges_out != 0) {
+                #pragma omp atomic
+                refined_external[refined_membership[node_id]] += edges_out;
+            }
+        }
+
+        int64_t num_proposed = 0;
+        #pragma omp parallel
+        {
+            std::vector<std::pair<int, double>> neighbor_communities;
+            #pragma omp for schedule(dynamic, 1024) reduction(+:num_proposed)
+            for(int node_id = 0; node_id < num_nodes; node_id ++) {
+                proposals[node_id] = -1;
+                if(refined_membership[node_id] != node_id || refined_counts[node_id] != 1 || !well_connected[node_id]) {
+                    continue;
+                }
+                if((HashVertex(this->seed, current_round, node_id) & 1) == 0) {
+                    continue;
+                }
+                int community = membership[node_id];
+                neighbor_communities.clear();
+                for(int64_t i = graph.offsets[node_id]; i < graph.offsets[node_id + 1]; i ++) {
+                    int neighbor = graph.neighbors[i];
+                    if(neighbor != node_id && membership[neighbor] == community) {
+                        neighbor_communities.push_back({refined_membership[neighbor], graph.weights[i]});
+                    }
+                }
+                std::sort(neighbor_communities.begin(), neighbor_communities.end());
+
+                double node_size = graph.node_sizes[node_id];
+                double node_strength = graph.node_strengths[node_id];
+                int best_community = -1;
+                double best_gain = 0;
+                for(size_t i = 0; i < neighbor_communities.size(); ) {
+                    int refined_community = neighbor_communities[i].first;
+                    double edges_to_community = 0;
+                    for(; i < neighbor_communities.size() && neighbor_communities[i].first == refined_community; i ++) {
+                        edges_to_community += neighbor_communities[i].second;
+                    }
+                    double refined_size = refined_sizes[refined_community];
+                    double refined_strength = refined_strengths[refined_community];
+                    bool target_well_connected = this->Gain(refined_external[refined_community], refined_size, refined_strength, community_sizes[community] - refined_size, community_strengths[community] - refined_strength, graph.total_strength) >= 0;
+                    if(!target_well_connected) {
+                        continue;
+                    }
+                    double current_gain = this->Gain(edges_to_community, node_size, node_strength, refined_size, refined_strength, graph.total_strength);
+                    if(current_gain >= 0 && (best_community == -1 || current_gain > best_gain + 1e-12)) {
+                        best_gain = current_gain;
+                        best_community = refined_community;
+                    }
+                }
+                if(best_community != -1) {
+                    proposals[node_id] = best_community;
+                    num_proposed ++;
+                }
+            }
+        }
+        if(num_proposed == 0) {
+            break;
+        }
+
+        // a singleton that is itself moving this round cannot be joined, which keeps merges from chaining
+        int64_t num_accepted = 0;
+        #pragma omp parallel for schedule(static) reduction(+:num_accepted)
+        for(int node_id = 0; node_id < num_nodes; node_id ++) {
+            int target = proposals[node_id];
+            accepted[node_id] = target != -1 && !(refined_counts[target] == 1 && proposals[target] != -1);
+            num_accepted += accepted[node_id];
+        }
+        if(num_accepted == 0) {
+            continue;
+        }
+        #pragma omp parallel for schedule(static)
+        for(int node_id = 0; node_id < num_nodes; node_id ++) {
+            if(accepted[node_id]) {
+                int target = proposals[node_id];
+                #pragma omp atomic
+                refined_sizes[target] += graph.node_sizes[node_id];
+                #pragma omp atomic
+                refined_strengths[target] += graph.node_strengths[node_id];
+                #pragma omp atomic
+                refined_counts[target] ++;
+                refined_sizes[node_id] = 0;
+                refined_strengths[node_id] = 0;
+                refined_counts[node_id] = 0;
+                refined_membership[node_id] = target;
+            }
+        }
+    }
+    return refined_membership;
+}
+
+CSRGraph ParallelLeiden::Aggregate(const CSRGraph& graph, const std::vector<int>& refined_membership, int num_refined) {
+    int num_nodes = graph.num_nodes;
+    std::vector<int64_t> member_offsets(num_refined + 1, 0);
+    for(int node_id = 0; node_id < num_nodes; node_id ++) {
+        member_offsets[refined_membership[node_id] + 1] ++;
+    }
+    for(int community = 0; community < num_refined; community ++) {
+        member_offsets[community + 1] += member_offsets[community];
+    }
+    // filled in node order so every community lists its members in ascending order
+    std::vector<int> members(num_nodes);
+    std::vector<int64_t> cursor(member_offsets.begin(), member_offsets.end() - 1);
+    for(int node_id = 0; node_id < num_nodes; node_id ++) {
+        members[cursor[refined_membership[node_id]] ++] = node_id;
+    }
+
+    CSRGraph coarse_graph;
+    coarse_graph.num_nodes = num_refined;
+    coarse_graph.total_strength = graph.total_strength;
+    coarse_graph.node_sizes.assign(num_refined, 0);
+    coarse_graph.node_strengths.assign(num_refined, 0);
+    std::vector<std::vector<std::pair<int, double>>> rows(num_refined);
+    #pragma omp parallel
+    {
+        std::vector<std::pair<int, double>> arcs;
+        #pragma omp for schedule(dynamic, 256)
+        for(int community = 0; community < num_refined; community ++) {
+            arcs.clear();
+            double internal_weight = 0;
+            double loop_weight = 0;
+            for(int64_t j = member_offsets[community]; j < member_offsets[community + 1]; j ++) {
+                int node_id = members[j];
+                coarse_graph.node_sizes[community] += graph.node_sizes[node_id];
+                coarse_graph.node_strengths[community] += graph.node_strengths[node_id];
+                for(int64_t i = graph.offsets[node_id]; i < graph.offsets[node_id + 1]; i ++) {
+                    int neighbor = graph.neighbors[i];
+                    int neighbor_community = refined_membership[neighbor];
+                    if(neighbor_community != community) {
+                        arcs.push_back({neighbor_community, graph.weights[i]});
+                    } else if(neighbor == node_id) {
+                        loop_weight += graph.weights[i];
+                    } else {
+                        internal_weight += graph.weights[i];
+                    }
+                }
+            }
+            std::stable_sort(arcs.begin(), arcs.end(), [](auto const& lhs, auto const& rhs) {
+                return lhs.first < rhs.first;
+            });
+            // internal edges were seen from both endpoints
+            double self_weight = internal_weight / 2 + loop_weight;
+            std::vector<std::pair<int, double>>& row = rows[community];
+            bool self_added = self_weight == 0;
+            for(size_t i = 0; i < arcs.size(); ) {
+                int neighbor_community = arcs[i].first;
+                double edge_weight = 0;
+                for(; i < arcs.size() && arcs[i].first == neighbor_community; i ++) {
+                    edge_weight += arcs[i].second;
+                }
+                if(!self_added && community < neighbor_community) {
+                    row.push_back({community, self_weight});
+                    self_added = true;
+                }
+                row.push_back({neighbor_community, edge_weight});
+            }
+            if(!self_added) {
+                row.push_back({community, self_weight});
+            }
+        }
+    }
+
+    coarse_graph.offsets.assign(num_refined + 1, 0);
+    for(int community = 0; community < num_refined; community ++) {
+        coarse_graph.offsets[community + 1] = coarse_graph.offsets[community] + rows[community].size();
+    }
+    coarse_graph.neighbors.resize(coarse_graph.offsets[num_refined]);
+    coarse_graph.weights.resize(coarse_graph.offsets[num_refined]);
+    #pragma omp parallel for schedule(dynamic, 256)
+    for(int community = 0; community < num_refined; community ++) {
+        int64_t position = coarse_graph.offsets[community];
+        for(auto const& [neighbor_community, edge_weight] : rows[community]) {
+            coarse_graph.neighbors[position] = neighbor_community;
+            coarse_graph.weights[position] = edge_weight;
+            position ++;
+        }
+        std::vector<std::pair<int, double>>().swap(rows[community]);
+    }
+    return coarse_graph;
+}
+
+int ParallelLeiden::Renumber(std::vector<int>& membership) {
+    int64_t num_labels = membership.size();
+    std::vector<int> new_label(num_labels, 0);
+    #pragma omp parallel for schedule(static)
+    for(int64_t i = 0; i < num_labels; i ++) {
+        #pragma omp atomic write
+        new_label[membership[i]] = 1;
+    }
+    int num_communities = 0;
+    for(int64_t i = 0; i < num_labels; i ++) {
+        new_label[i] = new_label[i] ? num_communities ++ : -1;
+    }
+    #pragma omp parallel for schedule(static)
+    for(int64_t i = 0; i < num_labels; i ++) {
+        membership[i] = new_label[membership[i]];
+    }
+    return num_communities;
+}
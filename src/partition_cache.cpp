@@ -0,0 +1,96 @@
+#include "partition_cache.h"
+#include "graph_coarsening.h"
+
+#include <bit>
+#include <charconv>
+#include <thread>
+#include <unistd.h>
+#include <omp.h>
+
+uint64_t PartitionCache::HashGraph(igraph_t* graph_ptr) {
+    // FNV-1a over fixed blocks of edges in parallel, then over the block hashes in order
+    const uint64_t fnv_offset = 0xcbf29ce484222325ULL;
+    const uint64_t fnv_prime = 0x100000001b3ULL;
+    const int64_t block_size = 1 << 20;
+    int64_t num_edges = igraph_ecount(graph_ptr);
+    igraph_vector_int_t edge_vector;
+    igraph_vector_int_init(&edge_vector, 0);
+    igraph_get_edgelist(graph_ptr, &edge_vector, false);
+
+    int64_t num_blocks = (num_edges + block_size - 1) / block_size;
+    std::vector<uint64_t> block_hashes(num_blocks);
+    #pragma omp parallel for schedule(static)
+    for(int64_t block = 0; block < num_blocks; block ++) {
+        uint64_t block_hash = fnv_offset;
+        int64_t block_end = std::min(num_edges, (block + 1) * block_size);
+        for(int64_t i = 2 * block * block_size; i < 2 * block_end; i ++) {
+            block_hash = (block_hash ^ static_cast<uint64_t>(VECTOR(edge_vector)[i])) * fnv_prime;
+        }
+        block_hashes[block] = block_hash;
+    }
+    igraph_vector_int_destroy(&edge_vector);
+
+    uint64_t graph_hash = fnv_offset;
+    graph_hash = (graph_hash ^ static_cast<uint64_t>(igraph_vcount(graph_ptr))) * fnv_prime;
+    graph_hash = (graph_hash ^ static_cast<uint64_t>(num_edges)) * fnv_prime;
+    for(int64_t block = 0; block < num_blocks; block ++) {
+        graph_hash = (graph_hash ^ block_hashes[block]) * fnv_prime;
+    }
+
+    // supernodes of a coarse graph can keep the same edges while their sizes and edge multiplicities change,
+    // and the algorithms cluster on those attributes
+    bool coarse_flag = GraphCoarsening::IsCoarseGraph(graph_ptr);
+    graph_hash = (graph_hash ^ static_cast<uint64_t>(coarse_flag)) * fnv_prime;
+    if(coarse_flag) {
+        igraph_vector_t attribute_vector;
+        igraph_vector_init(&attribute_vector, 0);
+        igraph_cattribute_EANV(graph_ptr, "coarse_weight", igraph_ess_all(IGRAPH_EDGEORDER_ID), &attribute_vector);
+        for(igraph_integer_t i = 0; i < igraph_vector_size(&attribute_vector); i ++) {
+            graph_hash = (graph_hash ^ std::bit_cast<uint64_t>(VECTOR(attribute_vector)[i])) * fnv_prime;
+        }
+        igraph_cattribute_VANV(graph_ptr, "coarse_size", igraph_vss_all(), &attribute_vector);
+        for(igraph_integer_t i = 0; i < igraph_vector_size(&attribute_vector); i ++) {
+            graph_hash = (graph_hash ^ std::bit_cast<uint64_t>(VECTOR(attribute_vector)[i])) * fnv_prime;
+        }
+        igraph_vector_destroy(&attribute_vector);
+    }
+    return graph_hash;
+}
+
+std::string PartitionCache::GetEntryFile(std::string algorithm, double clustering_parameter, int seed) {
+    char graph_hash_buffer[17];
+    auto [graph_hash_end, graph_hash_error] = std::to_chars(graph_hash_buffer, graph_hash_buffer + sizeof(graph_hash_buffer), this->graph_hash, 16);
+    char parameter_buffer[32];
+    auto [parameter_end, parameter_error] = std::to_chars(parameter_buffer, parameter_buffer + sizeof(parameter_buffer), clustering_parameter);
+    std::string entry_name = std::string(graph_hash_buffer, graph_hash_end) + "_" + algorithm + "_" + std::string(parameter_buffer, parameter_end) + "_" + std::to_string(seed) + ".ccmb";
+    return (std::filesystem::path(this->cache_directory) / entry_name).string();
+}
+
+bool PartitionCache::Lookup(std::string algorithm, double clustering_parameter, int seed, std::map<int, int>& partition_map) {
+    std::vector<uint32_t> labels;
+    if(!MembershipIO::ReadBinaryMembership(this->GetEntryFile(algorithm, clustering_parameter, seed), labels)) {
+        return false;
+    }
+    if(static_cast<int64_t>(labels.size()) != this->num_nodes) {
+        // a hash collision between graphs of different sizes, treat it as a miss
+        return false;
+    }
+    partition_map = MembershipIO::LabelsToPartitionMap(labels);
+    this->num_hits ++;
+    return true;
+}
+
+void PartitionCache::Store(std::string algorithm, double clustering_parameter, int seed, const std::map<int, int>& partition_map) {
+    std::string entry_file = this->GetEntryFile(algorithm, clustering_parameter, seed);
+    std::string temporary_file = entry_file + ".tmp." + std::to_string(getpid()) + "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    if(MembershipIO::WriteBinaryMembership(temporary_file, MembershipIO::PartitionMapToLabels(partition_map, this->num_nodes))) {
+        std::error_code rename_error;
+        std::filesystem::rename(temporary_file, entry_file, rename_error);
+        if(!rename_error) {
+            return;
+        }
+    }
+    // a cache that cannot be written only costs the recomputation next time
+    std::error_code remove_error;
+    std::filesystem::remove(temporary_file, remove_error);
+}
@@ -0,0 +1,106 @@
+#include "phase_metrics.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+
+void PhaseMetrics::Open(std::string metrics_file) {
+    PhaseMetrics::Close();
+    PhaseMetrics::metrics_fd = open(metrics_file.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    PhaseMetrics::open_time = std::chrono::steady_clock::now();
+    PhaseMetrics::open_pid = getpid();
+    const char* perf_phase = getenv("CONSENSUS_PERF_PHASE");
+    const char* perf_ctl_fd = getenv("CONSENSUS_PERF_CTL_FD");
+    const char* perf_ack_fd = getenv("CONSENSUS_PERF_ACK_FD");
+    if(perf_phase != nullptr && perf_ctl_fd != nullptr) {
+        PhaseMetrics::perf_phase = perf_phase;
+        PhaseMetrics::perf_ctl_fd = atoi(perf_ctl_fd);
+        PhaseMetrics::perf_ack_fd = (perf_ack_fd != nullptr) ? atoi(perf_ack_fd) : -1;
+    }
+}
+
+void PhaseMetrics::ControlPerf(std::string command) {
+    // perf answers every command on the ack descriptor once it has been applied
+    ssize_t num_written = write(PhaseMetrics::perf_ctl_fd, command.data(), command.size());
+    (void) num_written;
+    if(PhaseMetrics::perf_ack_fd != -1) {
+        char ack_buffer[5];
+        ssize_t num_read = read(PhaseMetrics::perf_ack_fd, ack_buffer, sizeof(ack_buffer));
+        (void) num_read;
+    }
+}
+
+void PhaseMetrics::Close() {
+    if(PhaseMetrics::metrics_fd != -1) {
+        close(PhaseMetrics::metrics_fd);
+        PhaseMetrics::metrics_fd = -1;
+    }
+}
+
+double PhaseMetrics::GetCpuSeconds(clockid_t cpu_clock) {
+    timespec cpu_time;
+    clock_gettime(cpu_clock, &cpu_time);
+    return cpu_time.tv_sec + cpu_time.tv_nsec * 1e-9;
+}
+
+double PhaseMetrics::GetTeamCpuSeconds() {
+    // the team of the calling thread is kept alive between parallel regions, so the difference of two sums is the
+    // CPU time its threads spent in between. threads that join the team later only add what they ran
+    double team_cpu_seconds = 0;
+    #pragma omp parallel reduction(+:team_cpu_seconds)
+    team_cpu_seconds += PhaseMetrics::GetCpuSeconds(CLOCK_THREAD_CPUTIME_ID);
+    return team_cpu_seconds;
+}
+
+PhaseMetrics::Phase::Phase(std::string name, int partition, bool worker_flag) : name(name), iteration(PhaseMetrics::current_iteration), partition(partition) {
+    if(PhaseMetrics::metrics_fd == -1) {
+        return;
+    }
+    // a forked worker is a process of its own, a worker thread shares the process with the others
+    this->team_flag = worker_flag && getpid() == PhaseMetrics::open_pid;
+    if(PhaseMetrics::perf_ctl_fd != -1 && this->name == PhaseMetrics::perf_phase) {
+        PhaseMetrics::ControlPerf("enable\n");
+    }
+    this->start_time = std::chrono::steady_clock::now();
+    this->start_cpu_seconds = this->team_flag ? PhaseMetrics::GetTeamCpuSeconds() : PhaseMetrics::GetCpuSeconds(CLOCK_PROCESS_CPUTIME_ID);
+}
+
+PhaseMetrics::Phase::~Phase() {
+    this->Finish();
+}
+
+void PhaseMetrics::Phase::Finish() {
+    if(this->finished_flag || PhaseMetrics::metrics_fd == -1) {
+        return;
+    }
+    this->finished_flag = true;
+    std::chrono::steady_clock::time_point end_time = std::chrono::steady_clock::now();
+    double cpu_seconds = (this->team_flag ? PhaseMetrics::GetTeamCpuSeconds() : PhaseMetrics::GetCpuSeconds(CLOCK_PROCESS_CPUTIME_ID)) - this->start_cpu_seconds;
+    if(PhaseMetrics::perf_ctl_fd != -1 && this->name == PhaseMetrics::perf_phase) {
+        PhaseMetrics::ControlPerf("disable\n");
+    }
+    std::string line = "{\"phase\":\"" + this->name + "\"";
+    if(this->iteration >= 0) {
+        line += ",\"iteration\":" + std::to_string(this->iteration);
+    }
+    if(this->partition >= 0) {
+        line += ",\"partition\":" + std::to_string(this->partition);
+    }
+    char times_buffer[160];
+    snprintf(times_buffer, sizeof(times_buffer), ",\"pid\":%d,\"start_seconds\":%.6f,\"wall_seconds\":%.6f,\"cpu_seconds\":%.6f", static_cast<int>(getpid()), std::chrono::duration<double>(this->start_time - PhaseMetrics::open_time).count(), std::chrono::duration<double>(end_time - this->start_time).count(), cpu_seconds);
+    line += times_buffer;
+    // counters that were not filled in are left out instead of written as -1
+    if(this->edges_processed >= 0) {
+        line += ",\"edges_processed\":" + std::to_string(this->edges_processed);
+    }
+    if(this->edges_surviving >= 0) {
+        line += ",\"edges_surviving\":" + std::to_string(this->edges_surviving);
+    }
+    if(this->unsettled_edges >= 0) {
+        line += ",\"unsettled_edges\":" + std::to_string(this->unsettled_edges);
+    }
+    line += "}\n";
+    ssize_t num_written = write(PhaseMetrics::metrics_fd, line.data(), line.size());
+    (void) num_written;
+}
@@ -0,0 +1,183 @@
+#include "shared_graph_segment.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <new>
+#include <vector>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+std::string SharedGraphSegment::GetSegmentName(std::string name) {
+    return "/consensus_clustering." + name;
+}
+
+uint64_t SharedGraphSegment::GetSourceKey(std::string edgelist, bool simplified) {
+    // the same file unchanged since it was published, loaded the same way
+    const uint64_t fnv_prime = 0x100000001b3ULL;
+    uint64_t source_key = 0xcbf29ce484222325ULL;
+    std::error_code path_error;
+    std::filesystem::path edgelist_path = std::filesystem::absolute(edgelist, path_error);
+    for(char c : edgelist_path.string()) {
+        source_key = (source_key ^ static_cast<uint8_t>(c)) * fnv_prime;
+    }
+    std::error_code size_error;
+    std::error_code time_error;
+    source_key = (source_key ^ std::filesystem::file_size(edgelist_path, size_error)) * fnv_prime;
+    source_key = (source_key ^ static_cast<uint64_t>(std::filesystem::last_write_time(edgelist_path, time_error).time_since_epoch().count())) * fnv_prime;
+    source_key = (source_key ^ static_cast<uint64_t>(simplified)) * fnv_prime;
+    return source_key;
+}
+
+int SharedGraphSegment::LockName(std::string segment_name) {
+    // the lock segment is never unlinked so every job locks the same file, a job without it runs unserialised
+    int lock_fd = shm_open((segment_name + ".lock").c_str(), O_CREAT | O_RDWR, 0600);
+    if(lock_fd != -1) {
+        flock(lock_fd, LOCK_EX);
+    }
+    return lock_fd;
+}
+
+void SharedGraphSegment::UnlockName(int lock_fd) {
+    if(lock_fd != -1) {
+        close(lock_fd);
+    }
+}
+
+std::unique_ptr<SharedGraphSegment> SharedGraphSegment::Attach(std::string name, uint64_t source_key) {
+    std::string segment_name = SharedGraphSegment::GetSegmentName(name);
+    int lock_fd = SharedGraphSegment::LockName(segment_name);
+    int segment_fd = shm_open(segment_name.c_str(), O_RDWR, 0);
+    if(segment_fd == -1) {
+        SharedGraphSegment::UnlockName(lock_fd);
+        return nullptr;
+    }
+    // waits while the publisher writes the edges and returns as soon as it is done or dead
+    flock(segment_fd, LOCK_SH);
+    Header* header = nullptr;
+    struct stat segment_stat;
+    if(fstat(segment_fd, &segment_stat) == 0 && segment_stat.st_size >= static_cast<off_t>(SharedGraphSegment::header_size)) {
+        void* header_mapping = mmap(NULL, SharedGraphSegment::header_size, PROT_READ | PROT_WRITE, MAP_SHARED, segment_fd, 0);
+        if(header_mapping != MAP_FAILED) {
+            header = static_cast<Header*>(header_mapping);
+        }
+    }
+    if(header == nullptr || !header->ready.load(std::memory_order_acquire)) {
+        // the publisher died before the edges were written, so the segment is removed and this job publishes again
+        if(header != nullptr) {
+            munmap(header, SharedGraphSegment::header_size);
+        }
+        shm_unlink(segment_name.c_str());
+        close(segment_fd);
+        SharedGraphSegment::UnlockName(lock_fd);
+        return nullptr;
+    }
+    if(std::memcmp(header->magic, "CCSG", 4) != 0 || header->version != SharedGraphSegment::version || header->source_key != source_key) {
+        munmap(header, SharedGraphSegment::header_size);
+        close(segment_fd);
+        SharedGraphSegment::UnlockName(lock_fd);
+        return nullptr;
+    }
+    void* data_mapping = mmap(NULL, header->data_size, PROT_READ, MAP_SHARED, segment_fd, SharedGraphSegment::header_size);
+    if(data_mapping == MAP_FAILED) {
+        munmap(header, SharedGraphSegment::header_size);
+        close(segment_fd);
+        SharedGraphSegment::UnlockName(lock_fd);
+        return nullptr;
+    }
+    SharedGraphSegment::UnlockName(lock_fd);
+    return std::unique_ptr<SharedGraphSegment>(new SharedGraphSegment(segment_name, segment_fd, header, static_cast<const char*>(data_mapping), header->data_size));
+}
+
+std::unique_ptr<SharedGraphSegment> SharedGraphSegment::Publish(std::string name, uint64_t source_key, igraph_t* graph_ptr) {
+    std::string segment_name = SharedGraphSegment::GetSegmentName(name);
+    int lock_fd = SharedGraphSegment::LockName(segment_name);
+    int segment_fd = shm_open(segment_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if(segment_fd != -1) {
+        // held until the edges are written so attaching jobs wait for them, or find out right away if this job dies
+        flock(segment_fd, LOCK_EX);
+    }
+    SharedGraphSegment::UnlockName(lock_fd);
+    if(segment_fd == -1) {
+        return nullptr;
+    }
+    int64_t num_edges = igraph_ecount(graph_ptr);
+    size_t data_size = std::max<size_t>(sizeof(int), 2 * num_edges * sizeof(int));
+    void* header_mapping = MAP_FAILED;
+    void* data_mapping = MAP_FAILED;
+    if(ftruncate(segment_fd, SharedGraphSegment::header_size + data_size) == 0) {
+        header_mapping = mmap(NULL, SharedGraphSegment::header_size, PROT_READ | PROT_WRITE, MAP_SHARED, segment_fd, 0);
+        data_mapping = mmap(NULL, data_size, PROT_READ | PROT_WRITE, MAP_SHARED, segment_fd, SharedGraphSegment::header_size);
+    }
+    if(header_mapping == MAP_FAILED || data_mapping == MAP_FAILED) {
+        if(header_mapping != MAP_FAILED) {
+            munmap(header_mapping, SharedGraphSegment::header_size);
+        }
+        if(data_mapping != MAP_FAILED) {
+            munmap(data_mapping, data_size);
+        }
+        // the exclusive lock goes first so a waiting job can take the name lock, and the name is only removed
+        // if an attaching job has not already removed it and published another segment under it
+        struct stat segment_stat;
+        fstat(segment_fd, &segment_stat);
+        close(segment_fd);
+        lock_fd = SharedGraphSegment::LockName(segment_name);
+        int current_fd = shm_open(segment_name.c_str(), O_RDONLY, 0);
+        struct stat current_stat;
+        if(current_fd != -1 && fstat(current_fd, &current_stat) == 0 && current_stat.st_ino == segment_stat.st_ino && current_stat.st_dev == segment_stat.st_dev) {
+            shm_unlink(segment_name.c_str());
+        }
+        if(current_fd != -1) {
+            close(current_fd);
+        }
+        SharedGraphSegment::UnlockName(lock_fd);
+        return nullptr;
+    }
+
+    int* edges = static_cast<int*>(data_mapping);
+    #pragma omp parallel for schedule(static)
+    for(int64_t current_edge = 0; current_edge < num_edges; current_edge ++) {
+        edges[2 * current_edge] = IGRAPH_FROM(graph_ptr, current_edge);
+        edges[2 * current_edge + 1] = IGRAPH_TO(graph_ptr, current_edge);
+    }
+    mprotect(data_mapping, data_size, PROT_READ);
+
+    Header* header = new(header_mapping) Header();
+    std::memcpy(header->magic, "CCSG", 4);
+    header->version = SharedGraphSegment::version;
+    header->source_key = source_key;
+    header->num_nodes = igraph_vcount(graph_ptr);
+    header->num_edges = num_edges;
+    header->data_size = data_size;
+    header->ready.store(1, std::memory_order_release);
+    flock(segment_fd, LOCK_SH);
+    return std::unique_ptr<SharedGraphSegment>(new SharedGraphSegment(segment_name, segment_fd, header, static_cast<const char*>(data_mapping), data_size));
+}
+
+SharedGraphSegment::~SharedGraphSegment() {
+    munmap(const_cast<char*>(this->data), this->data_size);
+    munmap(this->header, SharedGraphSegment::header_size);
+    int lock_fd = SharedGraphSegment::LockName(this->segment_name);
+    // only the last attached job gets the exclusive lock, jobs that were killed do not hold theirs anymore
+    if(flock(this->segment_fd, LOCK_EX | LOCK_NB) == 0) {
+        shm_unlink(this->segment_name.c_str());
+    }
+    close(this->segment_fd);
+    SharedGraphSegment::UnlockName(lock_fd);
+}
+
+void SharedGraphSegment::ToGraph(igraph_t* graph_ptr) const {
+    int64_t num_edges = this->NumEdges();
+    const int* edges = this->Edges();
+    igraph_vector_int_t edge_vector;
+    igraph_vector_int_init(&edge_vector, 2 * num_edges);
+    #pragma omp parallel for schedule(static)
+    for(int64_t i = 0; i < 2 * num_edges; i ++) {
+        VECTOR(edge_vector)[i] = edges[i];
+    }
+    igraph_create(graph_ptr, &edge_vector, this->NumNodes(), IGRAPH_UNDIRECTED);
+    igraph_vector_int_destroy(&edge_vector);
+}
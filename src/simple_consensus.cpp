@@ -6,46 +6,57 @@ bool SimpleConsensus::CheckConvergence(igraph_t* graph_ptr, double max_weight, i
         // Continuing without checking convergence
         return false;
     }
-    int count = 0;
-    int num_edges = 0;
+    PhaseMetrics::Phase convergence_phase("convergence");
+    int64_t count = 0;
+    int64_t num_edges = 0;
     igraph_eit_t eit;
     igraph_eit_create(graph_ptr, igraph_ess_all(IGRAPH_EDGEORDER_ID), &eit);
     for(; !IGRAPH_EIT_END(eit); IGRAPH_EIT_NEXT(eit)) {
-        igraph_real_t current_edge_weight = IGRAPH_EIT_GET(eit);
+        igraph_real_t current_edge_weight = EAN(graph_ptr, "weight", IGRAPH_EIT_GET(eit));
         if (current_edge_weight != 0 && current_edge_weight != max_weight) {
             count ++;
         }
         num_edges ++ ;
     }
     igraph_eit_destroy(&eit);
+    convergence_phase.edges_processed = num_edges;
+    convergence_phase.unsettled_edges = count;
     return count <= this->delta * num_edges; //returns true iff converged
 }
 
 int SimpleConsensus::main() {
     this->WriteToLogFile("Loading the initial graph" , 1);
-    FILE* edgelist_file = fopen(this->edgelist.c_str(), "r");
     igraph_t graph;
     igraph_set_attribute_table(&igraph_cattribute_table);
-    igraph_read_graph_edgelist(&graph, edgelist_file, 0, false);
-    fclose(edgelist_file);
+    bool simplify = false;
+    this->ReadEdgelist(&graph, simplify);
     this->WriteToLogFile("Finished loading the initial graph" , 1);
+    this->PreprocessGraph(&graph);
     this->WriteToLogFile("Started setting the default edge weights for the initial graph" , 1);
     Consensus::SetIgraphAllEdgesWeight(&graph, 1);
     this->WriteToLogFile("Finished setting the default edge weights for the initial graph" , 1);
+    bool iterative = true;
+    bool streaming_possible = false;
+    this->PlanMemory(&graph, iterative, streaming_possible);
 
     int iter_count = 0;
+    // weights are rounded to the build's edge weight type so settled edges compare equal to max_weight
+    EdgeWeightCodec weight_codec = EdgeWeightCodec::FromPartitionWeights(this->weight_vector);
     double max_weight = 0;
     for (unsigned int i = 0; i < this->weight_vector.size(); i ++) {
-        max_weight += this->weight_vector[i];
+        max_weight = weight_codec.AddWeight(max_weight, this->weight_vector[i]);
     }
 
     igraph_t next_graph;
+    this->ResumeFromCheckpoint(&graph, &next_graph, iter_count);
     while (!SimpleConsensus::CheckConvergence(&next_graph, max_weight, iter_count) && iter_count < max_iter) {
         if(iter_count != 0) {
             igraph_destroy(&graph);
             igraph_copy(&graph, &next_graph);
         }
         this->WriteToLogFile("Staring iteration: " + std::to_string(iter_count), 1);
+        ScratchArena::Scope iteration_scope;
+        PhaseMetrics::SetIteration(iter_count);
         this->WriteToLogFile("Starting to copy the intermediate graphs", 1);
         if(iter_count != 0) {
             igraph_destroy(&next_graph);
@@ -56,16 +67,20 @@ int SimpleConsensus::main() {
         Consensus::SetIgraphAllEdgesWeight(&next_graph, 1);
         this->WriteToLogFile("Finsihed setting the edge weight for the intermediate graph", 1);
 
-        std::vector<std::map<int, int>> results;
+        // workers finish in any order, so every result goes to the row of its partition
+        std::vector<std::map<int, int>> results(this->num_partitions);
         this->WriteToLogFile("Starting workers" , 1);
         this->StartWorkers(&graph);
         while(!Consensus::done_being_clustered_clusterings.empty()) {
-            results.push_back(Consensus::done_being_clustered_clusterings.front());
+            results[Consensus::done_being_clustered_indices.front()] = Consensus::done_being_clustered_clusterings.front();
             Consensus::done_being_clustered_clusterings.pop();
+            Consensus::done_being_clustered_indices.pop();
         }
 
         this->WriteToLogFile("Got results back from workers" , 1);
 
+        PhaseMetrics::Phase accumulation_phase("accumulation");
+        accumulation_phase.edges_processed = igraph_ecount(&graph) * this->num_partitions;
         for(int i = 0; i < this->num_partitions; i++) {
             this->WriteToLogFile("Starting to incorate results from worker: " + std::to_string(i) , 1);
             std::map<int, int> current_partition = results.at(i);
@@ -78,7 +93,7 @@ int SimpleConsensus::main() {
                 igraph_real_t edge_weight = EAN(&graph, "weight", current_edge);
                 if(edge_weight != 0 && edge_weight != max_weight) {
                     if(current_partition.at(from_node) != current_partition.at(to_node)) {
-                        edge_weight += (1 * (this->weight_vector[i]));
+                        edge_weight = weight_codec.AddWeight(edge_weight, this->weight_vector[i]);
                     }
                 }
                 SetIgraphEdgeWeightFromVertices(&next_graph, from_node, to_node, edge_weight);
@@ -86,16 +101,27 @@ int SimpleConsensus::main() {
             igraph_eit_destroy(&eit);
             this->WriteToLogFile("Finished incorpating results from worker: " + std::to_string(i) , 1);
         }
+        accumulation_phase.Finish();
         this->WriteToLogFile("Started removing edges from the intermediate graph" , 1);
-        Consensus::RemoveEdgesBasedOnThreshold(&next_graph, this->threshold * max_weight);
+        PhaseMetrics::Phase threshold_phase("threshold");
+        threshold_phase.edges_processed = igraph_ecount(&next_graph);
+        Consensus::RemoveEdgesBasedOnThreshold(&next_graph, weight_codec.FromWeightThreshold(this->threshold, max_weight));
+        threshold_phase.edges_surviving = igraph_ecount(&next_graph);
+        threshold_phase.Finish();
         this->WriteToLogFile("Finished removing edges from the intermediate graph" , 1);
         iter_count ++;
+        this->CheckpointIteration(&graph, &next_graph, iter_count);
     }
+    this->checkpoint_writer.reset();
+    PhaseMetrics::SetIteration(-1);
 
     this->WriteToLogFile("Simple consensus took " + std::to_string(iter_count) + " iterations", 1);
 
     this->WriteToLogFile("Started the final clustering run" , 1);
+    PhaseMetrics::Phase final_clustering_phase("final_clustering");
+    final_clustering_phase.edges_processed = igraph_ecount(&graph);
     std::map<int, int> final_partition = GetCommunities("", this->final_algorithm, 0, this->final_resolution, &graph);
+    final_clustering_phase.Finish();
     this->WriteToLogFile("Finished the final clustering run" , 1);
     igraph_destroy(&graph);
     if(iter_count != 0) {
@@ -103,9 +129,10 @@ int SimpleConsensus::main() {
     }
 
     this->WriteToLogFile("Started writing to the output clustering file" , 1);
-    this->WritePartitionMap(final_partition);
+    bool write_success = this->WritePartitionMap(final_partition);
     this->WriteToLogFile("Finished writing to the output clustering file" , 1);
+    this->LogMeasuredPeak();
 
 
-    return 0;
+    return write_success ? 0 : 1;
 }
@@ -1,12 +1,6 @@
 #include "simple_ensemble_clustering.h"
 
 int SimpleEnsembleClustering::main() {
-    this->WriteToLogFile("Loading clustering files" , 1);
-    std::vector<std::map<std::string, std::string>> input_clusterings;
-    for(int i = 0; i < this->clustering_files.size(); i ++) {
-        input_clusterings.push_back(Consensus::ReadClusteringFile(this->clustering_files[i]));
-    }
-
     this->WriteToLogFile("Loading clustering weights" , 1);
     std::vector<float> float_custering_weights;
     for(int i = 0; i < this->clustering_weights.size(); i++) {
@@ -14,89 +8,112 @@ int SimpleEnsembleClustering::main() {
     }
 
     this->WriteToLogFile("Loading the final graph" , 1);
+    PhaseMetrics::Phase load_phase("load");
     FILE* edgelist_file = fopen(this->edgelist.c_str(), "r");
     igraph_t graph;
     igraph_set_attribute_table(&igraph_cattribute_table);
     igraph_read_graph_ncol(&graph, edgelist_file, NULL, true, IGRAPH_ADD_WEIGHTS_YES, IGRAPH_UNDIRECTED);
     fclose(edgelist_file);
+    load_phase.edges_processed = igraph_ecount(&graph);
+    load_phase.Finish();
     this->WriteToLogFile("Finished loading the final graph", 1);
 
-
-    this->WriteToLogFile("Started setting the default edge weights for the final graph", 1);
-    Consensus::SetIgraphAllEdgesWeight(&graph, 0);
-    this->WriteToLogFile("Finished setting the default edge weights for the final graph", 1);
-
     this->WriteToLogFile("Started adding to edge weights for the final graph", 1);
-    igraph_eit_t eit;
-    igraph_eit_create(&graph, igraph_ess_all(IGRAPH_EDGEORDER_ID), &eit);
-    for(int i = 0; i < this->clustering_files.size(); i++) {
-        std::map<std::string, std::string> current_partition = input_clusterings[i];
-        IGRAPH_EIT_RESET(eit);
-        for(; !IGRAPH_EIT_END(eit); IGRAPH_EIT_NEXT(eit)) {
-            igraph_integer_t current_edge = IGRAPH_EIT_GET(eit);
-            int from_node = IGRAPH_FROM(&graph, current_edge);
-            int to_node = IGRAPH_TO(&graph, current_edge);
-            std::string from_node_id = VAS(&graph, "name", from_node);
-            std::string to_node_id = VAS(&graph, "name", to_node);
-            if(current_partition.contains(from_node_id) && current_partition.contains(to_node_id)) {
-                if(current_partition.at(from_node_id) == current_partition.at(to_node_id)) {
-                    igraph_real_t current_edge_weight = EAN(&graph, "weight", IGRAPH_EIT_GET(eit));
-                    SETEAN(&graph, "weight", IGRAPH_EIT_GET(eit), current_edge_weight + (1 * float_custering_weights[i]));
-                }
-            }
-        }
-    }
-
-    /* BEGIN min proposal */
-    IGRAPH_EIT_RESET(eit);
-    std::map<igraph_integer_t, float> edge_to_total_weight_map;
-    for(; !IGRAPH_EIT_END(eit); IGRAPH_EIT_NEXT(eit)) {
-        igraph_integer_t current_edge = IGRAPH_EIT_GET(eit);
-        int from_node = IGRAPH_FROM(&graph, current_edge);
-        int to_node = IGRAPH_TO(&graph, current_edge);
-        std::string from_node_id = VAS(&graph, "name", from_node);
-        std::string to_node_id = VAS(&graph, "name", to_node);
-        float current_weight_sum = 0.0;
-        for(int i = 0; i < this->clustering_files.size(); i++) {
-            std::map<std::string, std::string> current_partition = input_clusterings[i];
-            if(current_partition.contains(from_node_id) && current_partition.contains(to_node_id)) {
-                current_weight_sum += float_custering_weights[i];
-            }
-        }
-        edge_to_total_weight_map[current_edge] = current_weight_sum;
-    }
-    IGRAPH_EIT_RESET(eit);
-    for(; !IGRAPH_EIT_END(eit); IGRAPH_EIT_NEXT(eit)) {
-        igraph_integer_t current_edge = IGRAPH_EIT_GET(eit);
-        int from_node = IGRAPH_FROM(&graph, current_edge);
-        int to_node = IGRAPH_TO(&graph, current_edge);
-        std::string from_node_id = VAS(&graph, "name", from_node);
-        std::string to_node_id = VAS(&graph, "name", to_node);
-        std::cerr << "edge_to_total_weight_map[" << from_node_id << "-" <<to_node_id << "] " << edge_to_total_weight_map[current_edge] << std::endl;
-        /* igraph_integer_t current_edge = IGRAPH_EIT_GET(eit); */
-        igraph_real_t current_edge_weight = EAN(&graph, "weight", IGRAPH_EIT_GET(eit));
-        if(edge_to_total_weight_map[current_edge] > 0) {
-            std::cerr << "before normalize edge weight " << from_node_id << "-" <<to_node_id << " " << current_edge_weight << std::endl;
-            SETEAN(&graph, "weight", IGRAPH_EIT_GET(eit), current_edge_weight / edge_to_total_weight_map[current_edge]);
+    PhaseMetrics::Phase accumulation_phase("accumulation");
+    accumulation_phase.edges_processed = igraph_ecount(&graph) * this->clustering_files.size();
+    // clusterings are stored as one label per graph vertex so the edge sweeps never touch a string
+    NodeNameToIdMap node_name_to_id_map = Consensus::GetNodeNameToIdMap(&graph);
+    ClusteringFileReader clustering_file_reader(&node_name_to_id_map, Consensus::GetNodeNameIdMap(&graph), omp_get_max_threads());
+    igraph_vector_t edge_weight_vector;
+    igraph_vector_init(&edge_weight_vector, igraph_ecount(&graph));
+    try {
+        if(this->streaming) {
+            this->StreamEdgeWeights(&graph, clustering_file_reader, float_custering_weights, &edge_weight_vector);
+        } else {
+            this->AccumulateEdgeWeights(&graph, clustering_file_reader, float_custering_weights, &edge_weight_vector);
         }
+    } catch(const std::runtime_error& err) {
+        this->WriteToLogFile(err.what(), -1);
+        igraph_vector_destroy(&edge_weight_vector);
+        igraph_destroy(&graph);
+        return 1;
     }
-    igraph_eit_destroy(&eit);
-    /* END min proposal */
-
+    node_name_to_id_map.clear();
+    accumulation_phase.Finish();
     this->WriteToLogFile("Finsished adding to edge weights for the final graph" , 1);
 
-    this->WriteToLogFile("Started removing edges from the final graph", 1);
-    Consensus::RemoveEdgesBasedOnThreshold(&graph, this->threshold);
-    this->WriteToLogFile("Finished removing edges from the final graph", 1);
-
     this->WriteToLogFile("Started the final connected components run", 1);
-    std::map<int, int> final_partition = Consensus::GetConnectedComponents(&graph);
+    // thresholding and components are fused so the graph is never rebuilt
+    PhaseMetrics::Phase final_clustering_phase("final_clustering");
+    final_clustering_phase.edges_processed = igraph_ecount(&graph);
+    std::vector<uint32_t> final_labels = Consensus::GetThresholdComponents(&graph, &edge_weight_vector, this->threshold);
+    final_clustering_phase.Finish();
+    igraph_vector_destroy(&edge_weight_vector);
     this->WriteToLogFile("Finished the final connected components run", 1);
 
     this->WriteToLogFile("Started writing to the output clustering file", 1);
-    this->WritePartitionMapWithTranslation(final_partition, &graph);
+    bool write_success = this->WriteMembership(final_labels, this->output_file, &graph);
     this->WriteToLogFile("Finished writing to the output clustering file", 1);
 
     igraph_destroy(&graph);
-    return 0;
+    return write_success ? 0 : 1;
+}
+
+void SimpleEnsembleClustering::AccumulateEdgeWeights(igraph_t* graph_ptr, ClusteringFileReader& clustering_file_reader, const std::vector<float>& float_custering_weights, igraph_vector_t* edge_weight_vector) {
+    this->WriteToLogFile("Loading clustering files" , 1);
+    std::vector<std::vector<int>> input_clusterings = clustering_file_reader.Read(this->clustering_files);
+
+    int num_clusterings = input_clusterings.size();
+    igraph_integer_t num_edges = igraph_ecount(graph_ptr);
+    // the agreement weight and the min proposal total are both computed in a single pass over the edges
+    #pragma omp parallel for schedule(static)
+    for(igraph_integer_t current_edge = 0; current_edge < num_edges; current_edge ++) {
+        int from_node = IGRAPH_FROM(graph_ptr, current_edge);
+        int to_node = IGRAPH_TO(graph_ptr, current_edge);
+        double current_edge_weight = 0;
+        float current_weight_sum = 0.0;
+        for(int i = 0; i < num_clusterings; i ++) {
+            int from_label = input_clusterings[i][from_node];
+            int to_label = input_clusterings[i][to_node];
+            if(from_label != -1 && to_label != -1) {
+                current_weight_sum += float_custering_weights[i];
+                if(from_label == to_label) {
+                    current_edge_weight += float_custering_weights[i];
+                }
+            }
+        }
+        if(current_weight_sum > 0) {
+            current_edge_weight /= current_weight_sum;
+        }
+        VECTOR(*edge_weight_vector)[current_edge] = current_edge_weight;
+    }
+}
+
+void SimpleEnsembleClustering::StreamEdgeWeights(igraph_t* graph_ptr, ClusteringFileReader& clustering_file_reader, const std::vector<float>& float_custering_weights, igraph_vector_t* edge_weight_vector) {
+    // only one clustering is resident at a time, the agreement goes straight into the edge weights
+    igraph_integer_t num_edges = igraph_ecount(graph_ptr);
+    std::vector<float> edge_to_total_weight(num_edges, 0.0);
+    for(int i = 0; i < this->clustering_files.size(); i ++) {
+        this->WriteToLogFile("Folding in clustering file " + this->clustering_files[i], 2);
+        std::vector<int> current_clustering = clustering_file_reader.Read(this->clustering_files[i]);
+        float current_clustering_weight = float_custering_weights[i];
+        #pragma omp parallel for schedule(static)
+        for(igraph_integer_t current_edge = 0; current_edge < num_edges; current_edge ++) {
+            int from_label = current_clustering[IGRAPH_FROM(graph_ptr, current_edge)];
+            int to_label = current_clustering[IGRAPH_TO(graph_ptr, current_edge)];
+            if(from_label != -1 && to_label != -1) {
+                edge_to_total_weight[current_edge] += current_clustering_weight;
+                if(from_label == to_label) {
+                    VECTOR(*edge_weight_vector)[current_edge] += current_clustering_weight;
+                }
+            }
+        }
+    }
+
+    #pragma omp parallel for schedule(static)
+    for(igraph_integer_t current_edge = 0; current_edge < num_edges; current_edge ++) {
+        if(edge_to_total_weight[current_edge] > 0) {
+            VECTOR(*edge_weight_vector)[current_edge] /= edge_to_total_weight[current_edge];
+        }
+    }
 }
@@ -1,60 +1,498 @@
 #include "threshold_consensus.h"
 
-int ThresholdConsensus::main() {
-    std::vector<std::map<int, int>> results;
-    this->WriteToLogFile("Starting workers" , 1);
-    this->StartWorkers(nullptr);
-    while(!Consensus::done_being_clustered_clusterings.empty()) {
-        results.push_back(Consensus::done_being_clustered_clusterings.front());
-        Consensus::done_being_clustered_clusterings.pop();
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+static int GetDecimalDigits(std::string value) {
+    // digits after the decimal point, shifted by an exponent, so 0.05 and 5e-2 both have 2
+    size_t exponent_position = value.find_first_of("eE");
+    int exponent = (exponent_position == std::string::npos) ? 0 : std::stoi(value.substr(exponent_position + 1));
+    std::string mantissa = value.substr(0, exponent_position);
+    size_t point_position = mantissa.find('.');
+    int fraction_digits = (point_position == std::string::npos) ? 0 : mantissa.size() - point_position - 1;
+    return std::max(0, fraction_digits - exponent);
+}
+
+std::vector<double> ThresholdConsensus::ParseThresholds(const std::vector<std::string>& threshold_arguments) {
+    // every argument is either a single value or an inclusive start:stop:step range
+    std::vector<double> parsed_thresholds;
+    for(auto const& threshold_argument : threshold_arguments) {
+        size_t first_colon = threshold_argument.find(':');
+        if(first_colon == std::string::npos) {
+            parsed_thresholds.push_back(std::stod(threshold_argument));
+            continue;
+        }
+        size_t second_colon = threshold_argument.find(':', first_colon + 1);
+        if(second_colon == std::string::npos) {
+            throw std::invalid_argument("--threshold ranges have to be written as start:stop:step");
+        }
+        std::string start_argument = threshold_argument.substr(0, first_colon);
+        std::string stop_argument = threshold_argument.substr(first_colon + 1, second_colon - first_colon - 1);
+        std::string step_argument = threshold_argument.substr(second_colon + 1);
+        double start = std::stod(start_argument);
+        double stop = std::stod(stop_argument);
+        double step = std::stod(step_argument);
+        if(step <= 0 || stop < start) {
+            throw std::invalid_argument("--threshold ranges need a positive step and start <= stop");
+        }
+        // the range is walked in integer ticks of the finest decimal written, so 0.1:0.5:0.1 gives 0.3 and not
+        // 0.30000000000000004, and every value is the double closest to its decimal
+        const int max_digits = 15;
+        int num_digits = std::min(max_digits, std::max({GetDecimalDigits(start_argument), GetDecimalDigits(stop_argument), GetDecimalDigits(step_argument)}));
+        double tick_scale = std::pow(10.0, num_digits);
+        int64_t start_ticks = std::llround(start * tick_scale);
+        int64_t stop_ticks = std::llround(stop * tick_scale);
+        int64_t step_ticks = std::max<int64_t>(1, std::llround(step * tick_scale));
+        for(int64_t current_ticks = start_ticks; current_ticks <= stop_ticks; current_ticks += step_ticks) {
+            parsed_thresholds.push_back(current_ticks / tick_scale);
+        }
+    }
+    return parsed_thresholds;
+}
+
+std::string ThresholdConsensus::GetThresholdOutputFile(double current_threshold) {
+    if(this->thresholds.size() == 1) {
+        return this->output_file;
     }
-    this->WriteToLogFile("Got results back from workers" , 1);
+    char threshold_buffer[32];
+    auto [threshold_end, error_code] = std::to_chars(threshold_buffer, threshold_buffer + sizeof(threshold_buffer), current_threshold);
+    return this->output_file + "." + std::string(threshold_buffer, threshold_end);
+}
 
+template<typename EdgeIndex>
+void ThresholdConsensus::GetEdgeEndpoints(igraph_t* graph_ptr, VertexIndex* edge_endpoints) {
+    EdgeIndex num_edges = igraph_ecount(graph_ptr);
+    #pragma omp parallel for schedule(static)
+    for(EdgeIndex current_edge = 0; current_edge < num_edges; current_edge ++) {
+        igraph_integer_t from_node;
+        igraph_integer_t to_node;
+        igraph_edge(graph_ptr, current_edge, &from_node, &to_node);
+        edge_endpoints[2 * current_edge] = from_node;
+        edge_endpoints[2 * current_edge + 1] = to_node;
+    }
+}
 
-    this->WriteToLogFile("Loading the final graph" , 1);
-    FILE* edgelist_file = fopen(this->edgelist.c_str(), "r");
-    igraph_t graph;
-    igraph_set_attribute_table(&igraph_cattribute_table);
-    igraph_read_graph_edgelist(&graph, edgelist_file, 0, false);
-    fclose(edgelist_file);
-    this->WriteToLogFile("Finished loading the final graph" , 1);
+template<typename EdgeIndex>
+bool ThresholdConsensus::AccumulateShards(int64_t num_nodes, const VertexIndex* edge_endpoints, PlacedVector<DisagreementCount>& num_disagreements) {
+    // the next shard is read while the current one is counted so only two are held at a time. the endpoints index
+    // the rows at random, so they are placed like the other large arrays and keep their pages across shards
+    auto read_shard = [this](int partition_index, PlacedVector<uint32_t>* labels) {
+        uint64_t id_map;
+        return MembershipIO::ReadBinaryMembership(EnsembleGenerator::GetShardFile(this->shard_directory, partition_index), *labels, &id_map) && id_map == MembershipIO::identity_id_map;
+    };
+    EdgeIndex num_edges = num_disagreements.size();
+    PlacedVector<uint32_t> labels;
+    PlacedVector<uint32_t> next_labels;
+    bool success = read_shard(0, &labels);
+    for(int i = 0; i < this->num_partitions; i ++) {
+        if(!success || static_cast<int64_t>(labels.size()) != num_nodes) {
+            this->WriteToLogFile("Partition " + std::to_string(i) + " is missing from " + this->shard_directory + " or belongs to another graph", -1);
+            return false;
+        }
+        std::thread shard_reader;
+        if(i + 1 < this->num_partitions) {
+            shard_reader = std::thread([&read_shard, &success, &next_labels, i] { success = read_shard(i + 1, &next_labels); });
+        }
+        #pragma omp parallel for schedule(static)
+        for(EdgeIndex current_edge = 0; current_edge < num_edges; current_edge ++) {
+            if(labels[edge_endpoints[2 * current_edge]] != labels[edge_endpoints[2 * current_edge + 1]]) {
+                num_disagreements[current_edge] ++;
+            }
+        }
+        if(shard_reader.joinable()) {
+            shard_reader.join();
+        }
+        labels.swap(next_labels);
+    }
+    this->WriteToLogFile("Finished reading " + std::to_string(this->num_partitions) + " shards", 1);
+    return true;
+}
+
+int64_t ThresholdConsensus::GetStreamingChunkSize(int64_t num_nodes) {
+    // every pass holds one membership row and the union-find in memory next to a chunk of endpoints, counts and weights
+    const int64_t bytes_per_edge = 2 * sizeof(int32_t) + sizeof(DisagreementCount) + sizeof(EdgeWeight);
+    const int64_t min_chunk_size = 4096;
+    if(this->max_memory == 0) {
+        return int64_t(1) << 20;
+    }
+    int64_t resident_bytes = num_nodes * (sizeof(uint32_t) + 2 * sizeof(int));
+    if(this->max_memory - resident_bytes < min_chunk_size * bytes_per_edge) {
+        this->WriteToLogFile("--max-memory of " + std::to_string(this->max_memory) + " bytes is below the " + std::to_string(resident_bytes + min_chunk_size * bytes_per_edge) + " bytes the streaming passes need", -1);
+        return min_chunk_size;
+    }
+    return (this->max_memory - resident_bytes) / bytes_per_edge;
+}
+
+template<typename EdgeIndex>
+int ThresholdConsensus::RunOutOfCore(igraph_t* graph_ptr) {
+    // the edges, the disagreement counts, the weights and the memberships live in unlinked spill files and every
+    // step is a sequential pass over chunks of them, only the union-find and the final clustering graph stay resident
+    int64_t num_nodes = igraph_vcount(graph_ptr);
+    int64_t num_edges = igraph_ecount(graph_ptr);
+    int64_t chunk_size = this->GetStreamingChunkSize(num_nodes);
+    int64_t num_chunks = (num_edges + chunk_size - 1) / chunk_size;
+    this->WriteToLogFile("Out-of-core mode spills to " + this->out_of_core_directory + " and streams " + std::to_string(chunk_size) + " edges at a time, " + std::to_string(num_chunks) + " chunks per pass" + (this->max_memory == 0 ? std::string("") : " for a budget of " + std::to_string(this->max_memory) + " bytes"), 1);
+
+    MappedArray<VertexIndex> edge_endpoints(this->out_of_core_directory, 2 * num_edges);
+    ThresholdConsensus::GetEdgeEndpoints<EdgeIndex>(graph_ptr, edge_endpoints.Data());
+    edge_endpoints.Release(0, 2 * num_edges);
+
+    MappedArray<DisagreementCount> num_disagreements(this->out_of_core_directory, num_edges);
+    std::unique_ptr<PhaseMetrics::Phase> accumulation_phase;
+    auto accumulate_membership = [&](const uint32_t* labels) {
+        for(int64_t chunk_begin = 0; chunk_begin < num_edges; chunk_begin += chunk_size) {
+            int64_t chunk_end = std::min(num_edges, chunk_begin + chunk_size);
+            #pragma omp parallel for schedule(static)
+            for(EdgeIndex current_edge = chunk_begin; current_edge < static_cast<EdgeIndex>(chunk_end); current_edge ++) {
+                if(labels[edge_endpoints[2 * current_edge]] != labels[edge_endpoints[2 * current_edge + 1]]) {
+                    num_disagreements[current_edge] ++;
+                }
+            }
+            edge_endpoints.Release(2 * chunk_begin, 2 * chunk_end);
+            num_disagreements.Release(chunk_begin, chunk_end);
+        }
+    };
+    if(this->shard_directory.empty()) {
+        MappedArray<uint32_t> memberships(this->out_of_core_directory, this->num_partitions * num_nodes);
+        Consensus::partition_sink = [&memberships, num_nodes](int partition_index, const std::vector<uint32_t>& labels) {
+            std::copy(labels.begin(), labels.end(), memberships.Data() + partition_index * num_nodes);
+        };
+        this->WriteToLogFile("Starting workers" , 1);
+        this->StartWorkers(graph_ptr);
+        Consensus::partition_sink = nullptr;
+        while(!Consensus::done_being_clustered_clusterings.empty()) {
+            Consensus::done_being_clustered_clusterings.pop();
+            Consensus::done_being_clustered_indices.pop();
+        }
+        this->WriteToLogFile("Got results back from workers" , 1);
+        igraph_destroy(graph_ptr);
+
+        this->WriteToLogFile("Started computing the edge weights" , 1);
+        accumulation_phase = std::make_unique<PhaseMetrics::Phase>("accumulation");
+        accumulation_phase->edges_processed = num_edges * this->num_partitions;
+        for(int i = 0; i < this->num_partitions; i ++) {
+            accumulate_membership(memberships.Data() + i * num_nodes);
+            memberships.Release(i * num_nodes, (i + 1) * num_nodes);
+        }
+    } else {
+        igraph_destroy(graph_ptr);
+        this->WriteToLogFile("Started computing the edge weights from the shards in " + this->shard_directory , 1);
+        accumulation_phase = std::make_unique<PhaseMetrics::Phase>("accumulation");
+        accumulation_phase->edges_processed = num_edges * this->num_partitions;
+        std::vector<uint32_t> labels;
+        for(int i = 0; i < this->num_partitions; i ++) {
+            uint64_t id_map;
+            if(!MembershipIO::ReadBinaryMembership(EnsembleGenerator::GetShardFile(this->shard_directory, i), labels, &id_map) || id_map != MembershipIO::identity_id_map || static_cast<int64_t>(labels.size()) != num_nodes) {
+                this->WriteToLogFile("Partition " + std::to_string(i) + " is missing from " + this->shard_directory + " or belongs to another graph", -1);
+                return 1;
+            }
+            accumulate_membership(labels.data());
+        }
+        this->WriteToLogFile("Finished reading " + std::to_string(this->num_partitions) + " shards", 1);
+    }
+
+    accumulation_phase.reset();
+
+    MappedArray<EdgeWeight> edge_weights(this->out_of_core_directory, num_edges);
+    PhaseMetrics::Phase weight_conversion_phase("weight_conversion");
+    weight_conversion_phase.edges_processed = num_edges;
+    int64_t num_unsettled_edges = 0;
+    for(int64_t chunk_begin = 0; chunk_begin < num_edges; chunk_begin += chunk_size) {
+        int64_t chunk_end = std::min(num_edges, chunk_begin + chunk_size);
+        #pragma omp parallel for schedule(static) reduction(+:num_unsettled_edges)
+        for(EdgeIndex current_edge = chunk_begin; current_edge < static_cast<EdgeIndex>(chunk_end); current_edge ++) {
+            edge_weights[current_edge] = this->weight_codec.FromDisagreements(num_disagreements[current_edge]);
+            if(ThresholdConsensus::IsUnsettled(num_disagreements[current_edge], this->num_partitions)) {
+                num_unsettled_edges ++;
+            }
+        }
+        num_disagreements.Release(chunk_begin, chunk_end);
+        edge_weights.Release(chunk_begin, chunk_end);
+    }
+    weight_conversion_phase.unsettled_edges = num_unsettled_edges;
+    weight_conversion_phase.Finish();
+    this->WriteToLogFile("Finished computing the edge weights" , 1);
+
+    std::vector<double> sweep_thresholds(this->thresholds);
+    std::sort(sweep_thresholds.begin(), sweep_thresholds.end(), std::greater<double>());
+    sweep_thresholds.erase(std::unique(sweep_thresholds.begin(), sweep_thresholds.end()), sweep_thresholds.end());
+
+    // instead of sorting the edges every threshold unions the edges between it and the previous one, which
+    // yields the same components since they do not depend on the order of the unions
+    UnionFind<VertexIndex> union_find(num_nodes);
+    bool first_threshold = true;
+    EdgeWeight previous_threshold_weight = 0;
+    // a failed output is logged and the other thresholds are still written
+    bool write_success = true;
+    for(size_t threshold_index = 0; threshold_index < sweep_thresholds.size(); threshold_index ++) {
+        double current_threshold = sweep_thresholds[threshold_index];
+        PhaseMetrics::SetIteration(threshold_index);
+        PhaseMetrics::Phase threshold_phase("threshold");
+        threshold_phase.edges_processed = num_edges;
+        EdgeWeight current_threshold_weight = this->weight_codec.FromThreshold(current_threshold);
+        int64_t num_surviving_edges = 0;
+        igraph_vector_int_t surviving_edge_vector;
+        igraph_vector_int_init(&surviving_edge_vector, 0);
+        for(int64_t chunk_begin = 0; chunk_begin < num_edges; chunk_begin += chunk_size) {
+            int64_t chunk_end = std::min(num_edges, chunk_begin + chunk_size);
+            for(EdgeIndex current_edge = chunk_begin; current_edge < static_cast<EdgeIndex>(chunk_end); current_edge ++) {
+                EdgeWeight current_edge_weight = edge_weights[current_edge];
+                if(current_edge_weight < current_threshold_weight) {
+                    continue;
+                }
+                num_surviving_edges ++;
+                if(first_threshold || current_edge_weight < previous_threshold_weight) {
+                    union_find.Union(edge_endpoints[2 * current_edge], edge_endpoints[2 * current_edge + 1]);
+                }
+                if(!this->final_algorithm.empty()) {
+                    igraph_vector_int_push_back(&surviving_edge_vector, edge_endpoints[2 * current_edge]);
+                    igraph_vector_int_push_back(&surviving_edge_vector, edge_endpoints[2 * current_edge + 1]);
+                }
+            }
+            edge_endpoints.Release(2 * chunk_begin, 2 * chunk_end);
+            edge_weights.Release(chunk_begin, chunk_end);
+        }
+        first_threshold = false;
+        previous_threshold_weight = current_threshold_weight;
+        threshold_phase.edges_surviving = num_surviving_edges;
+        threshold_phase.Finish();
+        this->WriteToLogFile("Threshold " + std::to_string(current_threshold) + " keeps " + std::to_string(num_surviving_edges) + " of " + std::to_string(num_edges) + " edges", 1);
+
+        std::map<int, int> final_partition;
+        if(this->final_algorithm.empty()) {
+            this->WriteToLogFile("Started the final connected components run" , 1);
+            PhaseMetrics::Phase final_clustering_phase("final_clustering");
+            final_clustering_phase.edges_processed = num_surviving_edges;
+            final_partition = ThresholdConsensus::GetComponentsFromUnionFind(union_find);
+            this->WriteToLogFile("Finished the final connected components run" , 1);
+        } else {
+            igraph_t threshold_graph;
+            igraph_create(&threshold_graph, &surviving_edge_vector, num_nodes, IGRAPH_UNDIRECTED);
+            this->WriteToLogFile("Started the final clustering run" , 1);
+            PhaseMetrics::Phase final_clustering_phase("final_clustering");
+            final_clustering_phase.edges_processed = num_surviving_edges;
+            final_partition = Consensus::GetCommunities("", this->final_algorithm, 0, this->final_resolution, &threshold_graph);
+            this->WriteToLogFile("Finished the final clustering run" , 1);
+            igraph_destroy(&threshold_graph);
+        }
+        igraph_vector_int_destroy(&surviving_edge_vector);
+
+        this->WriteToLogFile("Started writing to the output clustering file" , 1);
+        write_success = this->WritePartitionMap(final_partition, this->GetThresholdOutputFile(current_threshold)) && write_success;
+        this->WriteToLogFile("Finished writing to the output clustering file" , 1);
+    }
+    this->LogMeasuredPeak();
 
+    return write_success ? 0 : 1;
+}
 
-    this->WriteToLogFile("Started setting the default edge weights for the final graph" , 1);
-    Consensus::SetIgraphAllEdgesWeight(&graph, 1.0);
-    this->WriteToLogFile("Finished setting the default edge weights for the final graph" , 1);
+template<typename EdgeIndex>
+int ThresholdConsensus::RunInMemory(igraph_t* graph_ptr) {
+    int64_t num_nodes;
+    EdgeIndex num_edges;
+    PlacedVector<VertexIndex> loaded_edge_endpoints;
+    const VertexIndex* edge_endpoints;
+    if(graph_ptr == nullptr) {
+        // reduce reads the endpoint pairs straight from the attached shared graph
+        num_nodes = this->shared_graph->NumNodes();
+        num_edges = this->shared_graph->NumEdges();
+        edge_endpoints = this->shared_graph->Edges();
+    } else {
+        num_nodes = igraph_vcount(graph_ptr);
+        num_edges = igraph_ecount(graph_ptr);
+        // the per-edge arrays are first-touched in the static chunks of the accumulation loops
+        loaded_edge_endpoints.resize(2 * static_cast<int64_t>(num_edges));
+        ThresholdConsensus::GetEdgeEndpoints<EdgeIndex>(graph_ptr, loaded_edge_endpoints.data());
+        edge_endpoints = loaded_edge_endpoints.data();
+    }
+    PlacedVector<DisagreementCount> num_disagreements(num_edges, 0);
+    // streaming runs record the accumulation of every partition in the sink, the other paths as one phase here
+    std::unique_ptr<PhaseMetrics::Phase> accumulation_phase;
+    if(this->shard_directory.empty() && !this->memory_plan.materialised_memberships) {
+        // the disagreement counts do not depend on the order the partitions finish in
+        this->WriteToLogFile("Started streaming the partitions into the edge weights" , 1);
+        Consensus::partition_sink = [edge_endpoints, &num_disagreements, num_edges](int partition_index, const std::vector<uint32_t>& labels) {
+            bool worker_flag = true;
+            PhaseMetrics::Phase accumulation_phase("accumulation", partition_index, worker_flag);
+            accumulation_phase.edges_processed = num_edges;
+            for(EdgeIndex current_edge = 0; current_edge < num_edges; current_edge ++) {
+                if(labels[edge_endpoints[2 * current_edge]] != labels[edge_endpoints[2 * current_edge + 1]]) {
+                    std::atomic_ref<DisagreementCount>(num_disagreements[current_edge]).fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        };
+        this->WriteToLogFile("Starting workers" , 1);
+        this->StartWorkers(graph_ptr);
+        Consensus::partition_sink = nullptr;
+        while(!Consensus::done_being_clustered_clusterings.empty()) {
+            Consensus::done_being_clustered_clusterings.pop();
+            Consensus::done_being_clustered_indices.pop();
+        }
+        this->WriteToLogFile("Got results back from workers" , 1);
+    } else if(this->shard_directory.empty()) {
+        std::vector<std::map<int, int>> results;
+        this->WriteToLogFile("Starting workers" , 1);
+        this->StartWorkers(graph_ptr);
+        while(!Consensus::done_being_clustered_clusterings.empty()) {
+            results.push_back(Consensus::done_being_clustered_clusterings.front());
+            Consensus::done_being_clustered_clusterings.pop();
+            Consensus::done_being_clustered_indices.pop();
+        }
+        this->WriteToLogFile("Got results back from workers" , 1);
 
-    this->WriteToLogFile("Started subtracting from edge weights for the final graph" , 1);
-    igraph_eit_t eit;
-    igraph_eit_create(&graph, igraph_ess_all(IGRAPH_EDGEORDER_ID), &eit);
-    for(int i = 0; i < this->num_partitions; i++) {
-        std::map<int,int> current_partition = results.at(i);
-        IGRAPH_EIT_RESET(eit);
-        for(; !IGRAPH_EIT_END(eit); IGRAPH_EIT_NEXT(eit)) {
-            igraph_integer_t current_edge = IGRAPH_EIT_GET(eit);
-            int from_node = IGRAPH_FROM(&graph, current_edge);
-            int to_node = IGRAPH_TO(&graph, current_edge);
-            if(current_partition.at(from_node) != current_partition.at(to_node)) {
-                igraph_real_t current_edge_weight = EAN(&graph, "weight", IGRAPH_EIT_GET(eit));
-                SETEAN(&graph, "weight", IGRAPH_EIT_GET(eit), current_edge_weight - ((double)1/this->num_partitions));
+        this->WriteToLogFile("Started computing the edge weights" , 1);
+        accumulation_phase = std::make_unique<PhaseMetrics::Phase>("accumulation");
+        accumulation_phase->edges_processed = static_cast<int64_t>(num_edges) * this->num_partitions;
+        #pragma omp parallel for schedule(static)
+        for(EdgeIndex current_edge = 0; current_edge < num_edges; current_edge ++) {
+            int from_node = edge_endpoints[2 * current_edge];
+            int to_node = edge_endpoints[2 * current_edge + 1];
+            for(int i = 0; i < this->num_partitions; i++) {
+                if(results[i].at(from_node) != results[i].at(to_node)) {
+                    num_disagreements[current_edge] ++;
+                }
+            }
+        }
+    } else {
+        this->WriteToLogFile("Started computing the edge weights from the shards in " + this->shard_directory , 1);
+        accumulation_phase = std::make_unique<PhaseMetrics::Phase>("accumulation");
+        accumulation_phase->edges_processed = static_cast<int64_t>(num_edges) * this->num_partitions;
+        if(!this->AccumulateShards<EdgeIndex>(num_nodes, edge_endpoints, num_disagreements)) {
+            if(graph_ptr != nullptr) {
+                igraph_destroy(graph_ptr);
             }
+            return 1;
+        }
+    }
+    accumulation_phase.reset();
+
+    PlacedVector<EdgeWeight> edge_weights(num_edges);
+    PhaseMetrics::Phase weight_conversion_phase("weight_conversion");
+    weight_conversion_phase.edges_processed = num_edges;
+    int64_t num_unsettled_edges = 0;
+    #pragma omp parallel for schedule(static) reduction(+:num_unsettled_edges)
+    for(EdgeIndex current_edge = 0; current_edge < num_edges; current_edge ++) {
+        edge_weights[current_edge] = this->weight_codec.FromDisagreements(num_disagreements[current_edge]);
+        if(ThresholdConsensus::IsUnsettled(num_disagreements[current_edge], this->num_partitions)) {
+            num_unsettled_edges ++;
         }
     }
-    igraph_eit_destroy(&eit);
-    this->WriteToLogFile("Finsished subtracting from edge weights for the final graph" , 1);
+    weight_conversion_phase.unsettled_edges = num_unsettled_edges;
+    weight_conversion_phase.Finish();
+    this->WriteToLogFile("Finished computing the edge weights" , 1);
+
+    // edges enter in descending weight order so every lower threshold extends the previous edge set and components
+    std::vector<EdgeIndex> edge_order(num_edges);
+    for(EdgeIndex current_edge = 0; current_edge < num_edges; current_edge ++) {
+        edge_order[current_edge] = current_edge;
+    }
+    std::stable_sort(edge_order.begin(), edge_order.end(), [&edge_weights](EdgeIndex lhs, EdgeIndex rhs) {
+        return edge_weights[lhs] > edge_weights[rhs];
+    });
+    std::vector<double> sweep_thresholds(this->thresholds);
+    std::sort(sweep_thresholds.begin(), sweep_thresholds.end(), std::greater<double>());
+    sweep_thresholds.erase(std::unique(sweep_thresholds.begin(), sweep_thresholds.end()), sweep_thresholds.end());
+
+    UnionFind<VertexIndex> union_find(num_nodes);
+    std::vector<char> surviving_edges(num_edges, 0);
+    EdgeIndex num_surviving_edges = 0;
+    // a failed output is logged and the other thresholds are still written
+    bool write_success = true;
+    for(size_t threshold_index = 0; threshold_index < sweep_thresholds.size(); threshold_index ++) {
+        double current_threshold = sweep_thresholds[threshold_index];
+        PhaseMetrics::SetIteration(threshold_index);
+        PhaseMetrics::Phase threshold_phase("threshold");
+        threshold_phase.edges_processed = num_edges;
+        EdgeWeight current_threshold_weight = this->weight_codec.FromThreshold(current_threshold);
+        for(; num_surviving_edges < num_edges && edge_weights[edge_order[num_surviving_edges]] >= current_threshold_weight; num_surviving_edges ++) {
+            EdgeIndex current_edge = edge_order[num_surviving_edges];
+            surviving_edges[current_edge] = 1;
+            union_find.Union(edge_endpoints[2 * current_edge], edge_endpoints[2 * current_edge + 1]);
+        }
+        threshold_phase.edges_surviving = num_surviving_edges;
+        threshold_phase.Finish();
+        this->WriteToLogFile("Threshold " + std::to_string(current_threshold) + " keeps " + std::to_string(num_surviving_edges) + " of " + std::to_string(num_edges) + " edges", 1);
 
-    this->WriteToLogFile("Started removing edges from the final graph" , 1);
-    Consensus::RemoveEdgesBasedOnThreshold(&graph, this->threshold);
-    this->WriteToLogFile("Finished removing edges from the final graph" , 1);
+        std::map<int, int> final_partition;
+        if(this->final_algorithm.empty()) {
+            this->WriteToLogFile("Started the final connected components run" , 1);
+            PhaseMetrics::Phase final_clustering_phase("final_clustering");
+            final_clustering_phase.edges_processed = num_surviving_edges;
+            final_partition = ThresholdConsensus::GetComponentsFromUnionFind(union_find);
+            this->WriteToLogFile("Finished the final connected components run" , 1);
+        } else {
+            // surviving edges keep their original order so a single threshold clusters the same graph as before
+            igraph_vector_int_t surviving_edge_vector;
+            igraph_vector_int_init(&surviving_edge_vector, 0);
+            igraph_vector_int_reserve(&surviving_edge_vector, 2 * static_cast<int64_t>(num_surviving_edges));
+            for(EdgeIndex current_edge = 0; current_edge < num_edges; current_edge ++) {
+                if(surviving_edges[current_edge]) {
+                    igraph_vector_int_push_back(&surviving_edge_vector, edge_endpoints[2 * current_edge]);
+                    igraph_vector_int_push_back(&surviving_edge_vector, edge_endpoints[2 * current_edge + 1]);
+                }
+            }
+            igraph_t threshold_graph;
+            igraph_create(&threshold_graph, &surviving_edge_vector, num_nodes, IGRAPH_UNDIRECTED);
+            igraph_vector_int_destroy(&surviving_edge_vector);
+            this->WriteToLogFile("Started the final clustering run" , 1);
+            PhaseMetrics::Phase final_clustering_phase("final_clustering");
+            final_clustering_phase.edges_processed = num_surviving_edges;
+            final_partition = Consensus::GetCommunities("", this->final_algorithm, 0, this->final_resolution, &threshold_graph);
+            this->WriteToLogFile("Finished the final clustering run" , 1);
+            igraph_destroy(&threshold_graph);
+        }
+
+        this->WriteToLogFile("Started writing to the output clustering file" , 1);
+        write_success = this->WritePartitionMap(final_partition, this->GetThresholdOutputFile(current_threshold)) && write_success;
+        this->WriteToLogFile("Finished writing to the output clustering file" , 1);
+    }
+    if(graph_ptr != nullptr) {
+        igraph_destroy(graph_ptr);
+    }
+    this->LogMeasuredPeak();
 
-    this->WriteToLogFile("Started the final clustering run" , 1);
-    std::map<int, int> final_partition = Consensus::GetCommunities("", this->final_algorithm, 0, this->final_resolution, &graph);
-    this->WriteToLogFile("Finished the final clustering run" , 1);
-    igraph_destroy(&graph);
+    return write_success ? 0 : 1;
+}
 
-    this->WriteToLogFile("Started writing to the output clustering file" , 1);
-    this->WritePartitionMap(final_partition);
-    this->WriteToLogFile("Finished writing to the output clustering file" , 1);
+int ThresholdConsensus::main() {
+    this->WriteToLogFile("Loading the graph" , 1);
+    igraph_t graph;
+    igraph_set_attribute_table(&igraph_cattribute_table);
+    bool simplify = false;
+    // reduce only reads the edge endpoints, so over an unmodified shared graph it needs no igraph copy of its own.
+    // everything else would copy the segment into a private graph and save nothing but the parsing
+    if(!this->shared_graph_name.empty() && (this->shard_directory.empty() || !this->out_of_core_directory.empty() || this->prune_mode != "none" || this->reorder_mode != "none")) {
+        this->WriteToLogFile("The shared graph " + this->shared_graph_name + " is only used by reduce in memory, loading the edge-list instead", 1);
+        this->shared_graph_name.clear();
+    }
+    if(!this->shared_graph_name.empty()) {
+        PhaseMetrics::Phase load_phase("load");
+        if(this->AttachSharedGraph(simplify)) {
+            load_phase.edges_processed = this->shared_graph->NumEdges();
+            load_phase.Finish();
+            this->WriteToLogFile("Finished loading the graph" , 1);
+            if(2 * this->shared_graph->NumEdges() <= std::numeric_limits<uint32_t>::max()) {
+                return this->RunInMemory<uint32_t>(nullptr);
+            }
+            return this->RunInMemory<int64_t>(nullptr);
+        }
+    }
+    this->ReadEdgelist(&graph, simplify);
+    this->WriteToLogFile("Finished loading the graph" , 1);
+    this->PreprocessGraph(&graph);
+    // out-of-core runs size their chunks from the budget instead and log that plan when they start
+    if(this->shard_directory.empty() && this->out_of_core_directory.empty()) {
+        bool iterative = false;
+        bool streaming_possible = true;
+        this->PlanMemory(&graph, iterative, streaming_possible);
+    }
 
-    return 0;
+    // endpoint positions run up to 2m, so graphs below 2^31 edges keep the 32-bit edge order and positions
+    int64_t num_edges = igraph_ecount(&graph);
+    if(2 * num_edges <= std::numeric_limits<uint32_t>::max()) {
+        return this->out_of_core_directory.empty() ? this->RunInMemory<uint32_t>(&graph) : this->RunOutOfCore<uint32_t>(&graph);
+    }
+    this->WriteToLogFile("Using 64-bit edge indices for " + std::to_string(num_edges) + " edges", 1);
+    return this->out_of_core_directory.empty() ? this->RunInMemory<int64_t>(&graph) : this->RunOutOfCore<int64_t>(&graph);
 }
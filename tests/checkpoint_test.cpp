@@ -0,0 +1,75 @@
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <unistd.h>
+
+#include "checkpoint.h"
+#include "test_check.h"
+
+static std::unique_ptr<IterationState> GetIterationState(uint64_t configuration_hash, int iteration) {
+    std::unique_ptr<IterationState> state = std::make_unique<IterationState>();
+    state->configuration_hash = configuration_hash;
+    state->iteration = iteration;
+    state->graph.num_nodes = 4 + iteration;
+    state->graph.edges = {0, 1, 1, 2, 2, 3, 0, iteration};
+    state->graph.weights = {1, 0.5, 0.25, static_cast<double>(iteration)};
+    state->next_graph.num_nodes = 3;
+    state->next_graph.edges = {0, 2};
+    state->next_graph.weights = {0.75};
+    return state;
+}
+
+static bool IsSameState(const IterationState& lhs, const IterationState& rhs) {
+    return lhs.configuration_hash == rhs.configuration_hash && lhs.iteration == rhs.iteration
+        && lhs.graph.num_nodes == rhs.graph.num_nodes && lhs.graph.edges == rhs.graph.edges && lhs.graph.weights == rhs.graph.weights
+        && lhs.next_graph.num_nodes == rhs.next_graph.num_nodes && lhs.next_graph.edges == rhs.next_graph.edges && lhs.next_graph.weights == rhs.next_graph.weights;
+}
+
+static std::string GetCheckpointFile(const std::filesystem::path& checkpoint_directory, int iteration) {
+    return (checkpoint_directory / ("checkpoint." + std::to_string(iteration) + ".ccck")).string();
+}
+
+static void FlipLastByte(const std::string& checkpoint_file) {
+    FILE* checkpoint_file_handle = fopen(checkpoint_file.c_str(), "r+b");
+    CHECK(checkpoint_file_handle != NULL);
+    if(checkpoint_file_handle == NULL) {
+        return;
+    }
+    fseek(checkpoint_file_handle, -1, SEEK_END);
+    int last_byte = fgetc(checkpoint_file_handle);
+    fseek(checkpoint_file_handle, -1, SEEK_END);
+    fputc(last_byte ^ 0xff, checkpoint_file_handle);
+    fclose(checkpoint_file_handle);
+}
+
+int main() {
+    const uint64_t configuration_hash = 0x5eed;
+    std::filesystem::path checkpoint_directory = std::filesystem::temp_directory_path() / ("checkpoint_test." + std::to_string(getpid()));
+    IterationState state;
+    CHECK(!CheckpointWriter::ReadLatest(checkpoint_directory.string(), configuration_hash, state));
+
+    // the writer flushes the submitted state when it is destroyed, one writer per iteration so none is superseded
+    for(int iteration = 1; iteration <= 3; iteration ++) {
+        CheckpointWriter checkpoint_writer(checkpoint_directory.string());
+        checkpoint_writer.Submit(GetIterationState(configuration_hash, iteration));
+    }
+    CHECK(!std::filesystem::exists(GetCheckpointFile(checkpoint_directory, 1)));
+    CHECK(std::filesystem::exists(GetCheckpointFile(checkpoint_directory, 2)));
+    CHECK(std::filesystem::exists(GetCheckpointFile(checkpoint_directory, 3)));
+    CHECK(CheckpointWriter::ReadLatest(checkpoint_directory.string(), configuration_hash, state));
+    CHECK(IsSameState(state, *GetIterationState(configuration_hash, 3)));
+
+    // a checkpoint of another configuration is never read
+    CHECK(!CheckpointWriter::ReadLatest(checkpoint_directory.string(), configuration_hash + 1, state));
+
+    // a corrupted newest checkpoint falls back to the one before it, and nothing is read once both are corrupted
+    FlipLastByte(GetCheckpointFile(checkpoint_directory, 3));
+    CHECK(CheckpointWriter::ReadLatest(checkpoint_directory.string(), configuration_hash, state));
+    CHECK(IsSameState(state, *GetIterationState(configuration_hash, 2)));
+    std::filesystem::resize_file(GetCheckpointFile(checkpoint_directory, 2), std::filesystem::file_size(GetCheckpointFile(checkpoint_directory, 2)) - 1);
+    CHECK(!CheckpointWriter::ReadLatest(checkpoint_directory.string(), configuration_hash, state));
+
+    std::filesystem::remove_all(checkpoint_directory);
+    return num_failures;
+}
@@ -0,0 +1,83 @@
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "membership_io.h"
+#include "memory_placement.h"
+#include "test_check.h"
+
+static void TestRoundTrip(const std::string& membership_file, const std::vector<uint32_t>& labels, uint32_t flags, uint64_t id_map) {
+    CHECK(MembershipIO::WriteBinaryMembership(membership_file, labels, flags, id_map));
+    CHECK(MembershipIO::IsBinaryMembershipFile(membership_file));
+    std::vector<uint32_t> read_labels;
+    uint64_t read_id_map = MembershipIO::identity_id_map;
+    CHECK(MembershipIO::ReadBinaryMembership(membership_file, read_labels, &read_id_map));
+    CHECK(read_labels == labels);
+    CHECK(read_id_map == id_map);
+}
+
+int main() {
+    std::filesystem::path test_directory = std::filesystem::temp_directory_path() / ("membership_io_test." + std::to_string(getpid()));
+    std::filesystem::create_directories(test_directory);
+    std::string membership_file = (test_directory / "membership.bin").string();
+
+    // labels around every varint length boundary, the largest label and nodes without a cluster
+    std::vector<uint32_t> labels = {0, 1, 126, 127, 128, 16382, 16383, 16384, 2097151, 2097152, MembershipIO::no_membership, UINT32_MAX - 1, 268435455, 268435456, MembershipIO::no_membership};
+    for(int i = 0; i < 10000; i ++) {
+        labels.push_back((i * 7919u) % 5003u);
+    }
+    std::vector<uint32_t> flag_sets = {0, MembershipIO::varint_flag};
+    if(MembershipIO::HasZstd()) {
+        flag_sets.push_back(MembershipIO::varint_flag | MembershipIO::zstd_flag);
+    }
+    for(uint32_t flags : flag_sets) {
+        TestRoundTrip(membership_file, labels, flags, MembershipIO::identity_id_map);
+        TestRoundTrip(membership_file, labels, flags, 0x9e3779b97f4a7c15ull);
+        TestRoundTrip(membership_file, {}, flags, MembershipIO::identity_id_map);
+    }
+
+    // rows large enough to be placed are read into a placed vector the same way
+    std::vector<uint32_t> large_labels(MemoryPlacement::min_placed_bytes / sizeof(uint32_t) + 1000);
+    for(size_t i = 0; i < large_labels.size(); i ++) {
+        large_labels[i] = i % 7919;
+    }
+    CHECK(MembershipIO::WriteBinaryMembership(membership_file, large_labels, MembershipIO::varint_flag));
+    PlacedVector<uint32_t> placed_labels;
+    CHECK(MembershipIO::ReadBinaryMembership(membership_file, placed_labels));
+    CHECK(std::equal(placed_labels.begin(), placed_labels.end(), large_labels.begin(), large_labels.end()));
+
+    // the labels convert to the partition map and back, leaving out the nodes without a cluster
+    std::map<int, int> partition_map = {{0, 3}, {2, 0}, {5, 3}};
+    std::vector<uint32_t> map_labels = MembershipIO::PartitionMapToLabels(partition_map, 7);
+    CHECK(map_labels == std::vector<uint32_t>({3, MembershipIO::no_membership, 0, MembershipIO::no_membership, MembershipIO::no_membership, 3, MembershipIO::no_membership}));
+    CHECK(MembershipIO::LabelsToPartitionMap(map_labels) == partition_map);
+
+    // a truncated file and a text membership file are not read as binary memberships
+    CHECK(MembershipIO::WriteBinaryMembership(membership_file, labels, MembershipIO::varint_flag));
+    std::filesystem::resize_file(membership_file, std::filesystem::file_size(membership_file) - 1);
+    std::vector<uint32_t> read_labels;
+    CHECK(!MembershipIO::ReadBinaryMembership(membership_file, read_labels));
+    // header sizes that do not match the file are rejected before anything is allocated from them
+    for(uint32_t flags : flag_sets) {
+        for(long offset : {16L, 32L}) {
+            CHECK(MembershipIO::WriteBinaryMembership(membership_file, labels, flags));
+            FILE* membership_file_handle = fopen(membership_file.c_str(), "r+b");
+            uint64_t corrupt_size = uint64_t(1) << 40;
+            fseek(membership_file_handle, offset, SEEK_SET);
+            fwrite(&corrupt_size, sizeof(corrupt_size), 1, membership_file_handle);
+            fclose(membership_file_handle);
+            CHECK(!MembershipIO::ReadBinaryMembership(membership_file, read_labels));
+        }
+    }
+    std::string text_file = (test_directory / "membership.tsv").string();
+    std::ofstream(text_file) << "0\t1\n1\t1\n";
+    CHECK(!MembershipIO::IsBinaryMembershipFile(text_file));
+
+    std::filesystem::remove_all(test_directory);
+    return num_failures;
+}
@@ -0,0 +1,93 @@
+#include <map>
+#include <vector>
+#include <sched.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "membership_io.h"
+#include "membership_ring_buffer.h"
+#include "test_check.h"
+
+// node i of partition p is in cluster p + i, odd nodes are left out of odd partitions
+static std::map<int, int> GetPartitionMap(int partition_index, int64_t num_nodes) {
+    std::map<int, int> partition_map;
+    for(int node_id = 0; node_id < num_nodes; node_id ++) {
+        if(partition_index % 2 == 0 || node_id % 2 == 0) {
+            partition_map[node_id] = partition_index + node_id;
+        }
+    }
+    return partition_map;
+}
+
+static void TestSingleProcess() {
+    MembershipRingBuffer ring_buffer(2, 5, 0);
+    int partition_index = -1;
+    std::vector<uint32_t> labels;
+    CHECK(!ring_buffer.TryPop(partition_index, labels));
+    ring_buffer.Push(ring_buffer.ClaimPartition(), GetPartitionMap(0, 5));
+    ring_buffer.Push(ring_buffer.ClaimPartition(), GetPartitionMap(1, 5));
+    CHECK(ring_buffer.TryPop(partition_index, labels));
+    CHECK(partition_index == 0);
+    CHECK(labels == MembershipIO::PartitionMapToLabels(GetPartitionMap(0, 5), 5));
+    CHECK(ring_buffer.TryPop(partition_index, labels));
+    CHECK(partition_index == 1);
+    CHECK(labels[1] == MembershipIO::no_membership);
+    CHECK(labels == MembershipIO::PartitionMapToLabels(GetPartitionMap(1, 5), 5));
+    CHECK(!ring_buffer.TryPop(partition_index, labels));
+}
+
+static void TestAcrossFork() {
+    // more partitions than slots so the producers have to wait for the parent to drain them
+    const int num_workers = 3;
+    const int num_partitions = 20;
+    const int64_t num_nodes = 37;
+    const int first_partition = 4;
+    MembershipRingBuffer ring_buffer(2, num_nodes, first_partition);
+    std::vector<pid_t> worker_pids;
+    for(int worker = 0; worker < num_workers; worker ++) {
+        pid_t pid = fork();
+        if(pid == 0) {
+            int num_pushed = 0;
+            for(int partition_index = ring_buffer.ClaimPartition(); partition_index < first_partition + num_partitions; partition_index = ring_buffer.ClaimPartition()) {
+                ring_buffer.Push(partition_index, GetPartitionMap(partition_index, num_nodes));
+                num_pushed ++;
+            }
+            ring_buffer.AddCacheHits(num_pushed);
+            _exit(0);
+        }
+        CHECK(pid > 0);
+        worker_pids.push_back(pid);
+    }
+    std::vector<int> times_received(first_partition + num_partitions, 0);
+    int partition_index = -1;
+    std::vector<uint32_t> labels;
+    for(int num_received = 0; num_received < num_partitions;) {
+        if(!ring_buffer.TryPop(partition_index, labels)) {
+            sched_yield();
+            continue;
+        }
+        num_received ++;
+        CHECK(partition_index >= first_partition && partition_index < first_partition + num_partitions);
+        if(partition_index >= first_partition && partition_index < first_partition + num_partitions) {
+            times_received[partition_index] ++;
+            CHECK(labels == MembershipIO::PartitionMapToLabels(GetPartitionMap(partition_index, num_nodes), num_nodes));
+        }
+    }
+    for(pid_t worker_pid : worker_pids) {
+        int status;
+        CHECK(waitpid(worker_pid, &status, 0) == worker_pid);
+        CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    }
+    for(int i = first_partition; i < first_partition + num_partitions; i ++) {
+        CHECK(times_received[i] == 1);
+    }
+    CHECK(!ring_buffer.TryPop(partition_index, labels));
+    // the counts the children added are visible in the parent
+    CHECK(ring_buffer.NumCacheHits() == num_partitions);
+}
+
+int main() {
+    TestSingleProcess();
+    TestAcrossFork();
+    return num_failures;
+}
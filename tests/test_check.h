@@ -0,0 +1,19 @@
+#ifndef TEST_CHECK_H
+#define TEST_CHECK_H
+#include <cstdio>
+
+/*
+ * Minimal checks for the ctest executables. A failed check is reported with
+ * its location and the test keeps going, main returns the number of failures.
+ */
+static inline int num_failures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if(!(condition)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            num_failures ++; \
+        } \
+    } while(0)
+
+#endif